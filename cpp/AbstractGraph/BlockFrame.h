@@ -0,0 +1,61 @@
+#pragma once
+
+#include <type_traits>
+
+#include "FrameBase.h"
+
+
+// N samples of T as a single frame
+// - fixed trip count and 64 byte alignment so += vectorizes
+template <typename T, int N>
+requires std::is_arithmetic_v<T> && (N > 0)
+struct BlockFrame : public FrameBase {
+    static constexpr int size = N;
+    static constexpr bool cheapToView = true;
+
+    BlockFrame() {
+        reset();
+    }
+
+    alignas(64) T data[N];
+
+    BlockFrame& operator+=(const BlockFrame &other) {
+        for (int i = 0; i < N; i++) {
+            data[i] += other.data[i];
+        }
+        return *(this);
+    }
+    BlockFrame operator+(const BlockFrame &other) const {
+        BlockFrame f = *(this);
+        f += other;
+        return f;
+    }
+    BlockFrame& operator*=(float gain) {
+        for (int i = 0; i < N; i++) {
+            data[i] *= gain;
+        }
+        return *(this);
+    }
+    BlockFrame operator*(float gain) const {
+        BlockFrame f = *(this);
+        f *= gain;
+        return f;
+    }
+    BlockFrame& addScaled(const BlockFrame &input, float gain) {
+        for (int i = 0; i < N; i++) {
+            data[i] += gain * input.data[i];
+        }
+        return *(this);
+    }
+    BlockFrame clone() {
+        return *(this);
+    }
+    void reset() {
+        for (int i = 0; i < N; i++) {
+            data[i] = T{};
+        }
+    }
+};
+
+static_assert(ViewableFrame<BlockFrame<float, 64>>);
+static_assert(ScalableFrame<BlockFrame<float, 64>>);
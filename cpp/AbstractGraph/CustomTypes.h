@@ -1,15 +1,19 @@
 #pragma once
+#include <cmath>
+#include <numbers>
 
+#include "BlockFrame.h"
 #include "FrameBase.h"
+#include "LaneFrame.h"
 #include "NodeBase.h"
 
 
 struct NullFrame : public FrameBase {
     NullFrame() {}
-    NullFrame& operator+=(const NullFrame &other) {
+    NullFrame& operator+=(const NullFrame&) {
         return *(this);
     }
-    NullFrame operator+(const NullFrame &other) const {
+    NullFrame operator+(const NullFrame&) const {
         return NullFrame();
     }
     NullFrame clone() {
@@ -62,31 +66,235 @@ struct FloatFrame : public FrameBase {
     void reset() {
         data = 0.f;
     }
+    FloatFrame& operator*=(float gain) {
+        data *= gain;
+        return *(this);
+    }
+    FloatFrame operator*(float gain) const {
+        FloatFrame f;
+        f.data = data * gain;
+        return f;
+    }
+    FloatFrame& addScaled(const FloatFrame &input, float gain) {
+        data += gain * input.data;
+        return *(this);
+    }
+    static FloatFrame lerp(const FloatFrame& from, const FloatFrame& to, float t) {
+        FloatFrame f;
+        f.data = from.data + (to.data - from.data) * t;
+        return f;
+    }
 };
 
 struct SourceNode : public Node<NullFrame, IntFrame> {
     using Node<NullFrame, IntFrame>::Node;
-    IntFrame tick(NullFrame input) {
+    NodePurity purity() const override {
+        return NodePurity::constant;
+    }
+    IntFrame tick(const NullFrame&) {
         IntFrame f;
         f.data = 1;
         return f;
     }
+    void processBlock(const NullFrame*, IntFrame* output, int count) override {
+        for (int i = 0; i < count; i++) {
+            output[i].data = 1;
+        }
+        lastOutput = output[count - 1];
+    }
 };
 
 struct UpcastNode : public Node<IntFrame, FloatFrame> {
     using Node<IntFrame, FloatFrame>::Node;
-    FloatFrame tick(IntFrame input) {
+    NodePurity purity() const override {
+        return NodePurity::pure;
+    }
+    FloatFrame tick(const IntFrame& input) {
         FloatFrame f;
         f.data = static_cast<float>(input.data);
         return f;
     }
+    void processBlock(const IntFrame* input, FloatFrame* output, int count) override {
+        for (int i = 0; i < count; i++) {
+            output[i].data = static_cast<float>(input[i].data);
+        }
+        lastOutput = output[count - 1];
+    }
 };
 
 struct FloatNode : public Node<FloatFrame, FloatFrame> {
     using Node<FloatFrame, FloatFrame>::Node;
-    FloatFrame tick(FloatFrame input) {
+    FloatFrame tick(const FloatFrame& input) {
         FloatFrame f;
         f.data = input.data + lastOutput.data;
         return f;
     }
-};
\ No newline at end of file
+};
+
+struct DecayNode : public Node<FloatFrame, FloatFrame> {
+    using Node<FloatFrame, FloatFrame>::Node;
+    NodePurity purity() const override {
+        return NodePurity::pure;
+    }
+    FloatFrame tick(const FloatFrame& input) {
+        FloatFrame f;
+        f.data = input.data * 0.5f;
+        return f;
+    }
+};
+
+// synthetic load for generated graphs: `work` dependent multiply-adds per tick
+struct WorkNode : public Node<FloatFrame, FloatFrame> {
+    using Node<FloatFrame, FloatFrame>::Node;
+    NodePurity purity() const override {
+        return NodePurity::pure;
+    }
+    FloatFrame tick(const FloatFrame& input) {
+        FloatFrame f;
+        f.data = input.data;
+        for (int i = 0; i < work; i++) {
+            f.data = f.data * 0.999f + 0.001f;
+        }
+        return f;
+    }
+    int work = 0;
+};
+
+// input * gain, the extra node a weighted edge replaces
+struct GainNode : public Node<FloatFrame, FloatFrame> {
+    using Node<FloatFrame, FloatFrame>::Node;
+    NodePurity purity() const override {
+        return NodePurity::pure;
+    }
+    FloatFrame tick(const FloatFrame& input) {
+        return input * gain;
+    }
+    float gain = 1.f;
+};
+
+// sine LFO scaled by its input, ticked every `divisor` samples
+// - the phase advances by a whole control period per tick, so the frequency does not depend on the divisor
+struct LfoNode : public Node<FloatFrame, FloatFrame> {
+    using Node<FloatFrame, FloatFrame>::Node;
+    NodeRate rate() const override {
+        return { divisor, interpolate };
+    }
+    FloatFrame tick(const FloatFrame& input) {
+        FloatFrame f;
+        f.data = input.data * std::sin(phase);
+        phase += increment * static_cast<float>(divisor);
+        if (phase > 2.f * std::numbers::pi_v<float>) {
+            phase -= 2.f * std::numbers::pi_v<float>;
+        }
+        return f;
+    }
+    void reset() override {
+        Node<FloatFrame, FloatFrame>::reset();
+        phase = 0.f;
+    }
+    // radians per sample
+    float increment = 0.f;
+    float phase = 0.f;
+    int divisor = 1;
+    bool interpolate = false;
+};
+
+// 512 interleaved stereo samples as one frame
+using StereoBlockFrame = BlockFrame<float, 2 * 512>;
+
+struct StereoSourceNode : public Node<NullFrame, StereoBlockFrame> {
+    using Node<NullFrame, StereoBlockFrame>::Node;
+    NodePurity purity() const override {
+        return NodePurity::constant;
+    }
+    StereoBlockFrame tick(const NullFrame&) {
+        StereoBlockFrame f;
+        for (int i = 0; i < StereoBlockFrame::size; i++) {
+            f.data[i] = 1.f;
+        }
+        return f;
+    }
+};
+
+struct StereoDecayNode : public Node<StereoBlockFrame, StereoBlockFrame> {
+    using Node<StereoBlockFrame, StereoBlockFrame>::Node;
+    NodePurity purity() const override {
+        return NodePurity::pure;
+    }
+    StereoBlockFrame tick(const StereoBlockFrame& input) {
+        StereoBlockFrame f;
+        for (int i = 0; i < StereoBlockFrame::size; i++) {
+            f.data[i] = input.data[i] * 0.5f;
+        }
+        return f;
+    }
+};
+
+// ----------------
+// Polyphonic nodes
+// one instance runs N voices as lanes: state is one array per field across lanes (structure of arrays)
+// - lanes outside the mask output 0, voice allocation only flips mask bits, see VoiceAllocator
+// - N = 1 is the same voice cloned per instance
+
+// naive saw, one phase per lane
+template <int N>
+struct PolyOscillatorNode : public Node<NullFrame, LaneFrame<float, N>> {
+    using Node<NullFrame, LaneFrame<float, N>>::Node;
+    const LaneMask<N>* mask = nullptr;
+    alignas(32) float phase[N] = {};
+    alignas(32) float increment[N] = {};
+
+    void noteOn(int lane, float frequency, float sampleRate) {
+        phase[lane] = 0.f;
+        increment[lane] = frequency / sampleRate;
+    }
+
+    LaneFrame<float, N> tick(const NullFrame&) {
+        LaneFrame<float, N> f;
+        for (int lane = 0; lane < N; lane++) {
+            phase[lane] += increment[lane];
+            phase[lane] -= static_cast<float>(static_cast<int>(phase[lane]));
+            f.data[lane] = (2.f * phase[lane] - 1.f) * mask->gate[lane];
+        }
+        return f;
+    }
+};
+
+// exponential decay per lane, restarted by noteOn
+template <int N>
+struct PolyEnvelopeNode : public Node<LaneFrame<float, N>, LaneFrame<float, N>> {
+    using Node<LaneFrame<float, N>, LaneFrame<float, N>>::Node;
+    const LaneMask<N>* mask = nullptr;
+    alignas(32) float level[N] = {};
+    alignas(32) float decay[N] = {};
+
+    void noteOn(int lane, float decayPerSample) {
+        level[lane] = 1.f;
+        decay[lane] = decayPerSample;
+    }
+
+    LaneFrame<float, N> tick(const LaneFrame<float, N>& input) {
+        LaneFrame<float, N> f;
+        for (int lane = 0; lane < N; lane++) {
+            level[lane] *= decay[lane];
+            f.data[lane] = input.data[lane] * level[lane] * mask->gate[lane];
+        }
+        return f;
+    }
+};
+
+// sums the lanes back into one mono frame
+template <int N>
+struct LaneMixNode : public Node<LaneFrame<float, N>, FloatFrame> {
+    using Node<LaneFrame<float, N>, FloatFrame>::Node;
+    NodePurity purity() const override {
+        return NodePurity::pure;
+    }
+    FloatFrame tick(const LaneFrame<float, N>& input) {
+        FloatFrame f;
+        for (int lane = 0; lane < N; lane++) {
+            f.data += input.data[lane];
+        }
+        return f;
+    }
+};
@@ -0,0 +1,131 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "../misc/ThreadPool.h"
+#include "Graph.h"
+#include "WorkStealingDeque.h"
+
+// dataflow executor for a compiled plan
+// - every step has an atomic pending-input counter, reset from plan.dependencyCounts each tick/block
+// - finishing a step decrements its consumers; a consumer that reaches 0 goes on the finishing worker's deque
+// - idle workers steal from the other deques, so no step waits on anything but its own inputs
+// - workers sleep on the pool semaphore between ticks/blocks
+struct DagExecutor {
+    DagExecutor(const ExecutionPlan& plan, int workerCount)
+        : plan(plan),
+          workerCount(workerCount < 1 ? 1 : workerCount),
+          stepCount(static_cast<int>(plan.steps.size())),
+          pending(std::make_unique<std::atomic<int>[]>(plan.steps.size())),
+          pool(0) {
+
+        for (int worker = 0; worker < this->workerCount; worker++) {
+            deques.emplace_back(std::make_unique<WorkStealingDeque>(stepCount));
+        }
+        for (int i = 0; i < stepCount; i++) {
+            if (plan.dependencyCounts[i] == 0) {
+                sources.emplace_back(i);
+            }
+        }
+
+        for (int worker = 1; worker < this->workerCount; worker++) {
+            pool.addWorker([this, worker] {
+                while (true) {
+                    pool.newWorkSemaphore.acquire();
+                    if (pool.done) {
+                        break;
+                    }
+                    work(worker);
+                    finished.fetch_add(1, std::memory_order_release);
+                }
+            });
+        }
+    }
+
+    // one sample
+    void run() {
+        execute(0);
+    }
+
+    // one block, count must not exceed the size given to Graph::prepareBlock()
+    void runBlock(int count) {
+        execute(count);
+    }
+
+private:
+    void execute(int count) {
+        plan.refreshChangedConstants();
+        blockCount = count;
+        for (int i = 0; i < stepCount; i++) {
+            pending[i].store(plan.dependencyCounts[i], std::memory_order_relaxed);
+        }
+        for (auto& deque : deques) {
+            deque->reset();
+        }
+        for (int source : sources) {
+            deques[0]->push(source);
+        }
+        remaining.store(stepCount, std::memory_order_relaxed);
+        finished.store(0, std::memory_order_relaxed);
+
+        for (int worker = 1; worker < workerCount; worker++) {
+            pool.enqueue();
+        }
+        work(0);
+
+        // workers must be back on the semaphore before the next tick resets the counters
+        int spins = 0;
+        while (finished.load(std::memory_order_acquire) < workerCount - 1) {
+            if (++spins > spinLimit) {
+                std::this_thread::yield();
+            }
+        }
+        plan.commitFeedback(blockCount);
+    }
+
+    void work(int worker) {
+        WorkStealingDeque& own = *deques[worker];
+        int spins = 0;
+        while (remaining.load(std::memory_order_acquire) > 0) {
+            int step = own.pop();
+            for (int victim = 1; step == WorkStealingDeque::empty && victim < workerCount; victim++) {
+                step = deques[(worker + victim) % workerCount]->steal();
+            }
+            if (step == WorkStealingDeque::empty) {
+                if (++spins > spinLimit) {
+                    std::this_thread::yield();
+                }
+                continue;
+            }
+            spins = 0;
+
+            plan.runStep(step, blockCount);
+
+            for (int c = plan.consumerOffsets[step]; c < plan.consumerOffsets[step + 1]; c++) {
+                int consumer = plan.consumers[c];
+                if (pending[consumer].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    own.push(consumer);
+                }
+            }
+            remaining.fetch_sub(1, std::memory_order_acq_rel);
+        }
+    }
+
+    static constexpr int spinLimit = 1 << 10;
+
+    const ExecutionPlan& plan;
+    int workerCount;
+    int stepCount;
+    std::vector<int> sources;
+    std::vector<std::unique_ptr<WorkStealingDeque>> deques;
+    std::unique_ptr<std::atomic<int>[]> pending;
+
+    int blockCount = 0;
+    std::atomic<int> remaining = 0;
+    std::atomic<int> finished = 0;
+
+    // declared last: joins the workers before anything they touch is destroyed
+    ThreadPool pool;
+};
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <concepts>
 // #include <type_traits> // included by <concepts>
 
@@ -17,8 +18,40 @@ concept Frame =
         { b + c } -> std::same_as<T>;
         { a += b } -> std::same_as<T&>;
         { a.reset() } -> std::same_as<void>;
-        
-        // { b * c } -> std::same_as<T>;
-        // { a *= b } -> std::same_as<void>;
 };
 
+// frames an edge gain can scale, see Graph::connect(source, destination, gain)
+// - addScaled(input, gain) is the fused `frame += gain * input` of the accumulation loops: one pass, no temporary
+template <typename T>
+concept ScalableFrame = Frame<T> && requires(T a, const T b, float gain) {
+    { b * gain } -> std::same_as<T>;
+    { a *= gain } -> std::same_as<T&>;
+    { a.addScaled(b, gain) } -> std::same_as<T&>;
+};
+
+// frames that are expensive to copy (multi-sample, multi-channel) declare
+//     static constexpr bool cheapToView = true;
+// executors then hand a single provider's output to the consumer by const reference
+// instead of accumulating it into a fresh frame first
+template <typename T>
+concept ViewableFrame = Frame<T> && requires { requires T::cheapToView; };
+
+// frames a control-rate node can ramp between, see NodeRate
+//     static T lerp(const T& from, const T& to, float t);
+template <typename T>
+concept InterpolableFrame = Frame<T> && requires(const T a, const T b, float t) {
+    { T::lerp(a, b, t) } -> std::same_as<T>;
+};
+
+// small dense frame type ids, replaces std::type_index where the id is used as an index
+// - one id per frame type, handed out on first use, no RTTI involved
+// - nodes cache their ids at construction so the hot path only reads an int
+// - atomic: graphs on different threads can hand out ids for new frame types at the same time
+inline std::atomic<int> nextFrameTypeId = 0;
+
+template <Frame T>
+int frameTypeId() {
+    static const int id = nextFrameTypeId.fetch_add(1, std::memory_order_relaxed);
+    return id;
+}
+
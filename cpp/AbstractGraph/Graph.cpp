@@ -1,3 +1,627 @@
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_map>
+
 #include "Graph.h"
 
-Graph* Graph::context = nullptr;
+thread_local Graph* Graph::context = nullptr;
+
+AdjacencyCsr AdjacencyCsr::fromEdges(int nodeCount, const std::vector<std::pair<int, int>>& edges) {
+    AdjacencyCsr csr;
+    csr.offsets.assign(nodeCount + 1, 0);
+    for (auto [source, destination] : edges) {
+        csr.offsets[destination + 1]++;
+    }
+    for (int i = 0; i < nodeCount; i++) {
+        csr.offsets[i + 1] += csr.offsets[i];
+    }
+    csr.inputs.resize(edges.size());
+    std::vector<int> cursor(csr.offsets.begin(), csr.offsets.end() - 1);
+    for (auto [source, destination] : edges) {
+        csr.inputs[cursor[destination]++] = source;
+    }
+    return csr;
+}
+
+void Graph::prepare() {
+    if (!adjacencyFromCsr) {
+        // index every node once so the sort can work on flat arrays
+        // - nodes that were wired with >> but never added to `nodes` are picked up here
+        nodeIndex.clear();
+        nodeIndex.reserve(nodes.size());
+        for (int i = 0; i < static_cast<int>(nodes.size()); i++) {
+            nodeIndex[nodes[i]] = i;
+        }
+        auto registerNode = [this](AbstractNode* node) {
+            if (nodeIndex.try_emplace(node, static_cast<int>(nodes.size())).second) {
+                nodes.emplace_back(node);
+            }
+        };
+        for (auto adjacency : { &nodeAdjacencyMap, &feedbackAdjacencyMap }) {
+            for (auto& [node, inputs] : *adjacency) {
+                registerNode(node);
+                for (auto input : inputs) {
+                    registerNode(input);
+                }
+            }
+        }
+
+        auto toCsr = [this](const std::map<AbstractNode*, std::vector<AbstractNode*>>& adjacency) {
+            std::vector<std::pair<int, int>> edges;
+            for (auto& [node, inputs] : adjacency) {
+                for (auto input : inputs) {
+                    edges.emplace_back(nodeIndex.at(input), nodeIndex.at(node));
+                }
+            }
+            return AdjacencyCsr::fromEdges(static_cast<int>(nodes.size()), edges);
+        };
+        inputCsr = toCsr(nodeAdjacencyMap);
+        feedbackCsr = toCsr(feedbackAdjacencyMap);
+
+        // the counting sort keeps every consumer's inputs in map order, so its k-th input is edge begin + k
+        inputCsrGains.clear();
+        if (!inputGains.empty()) {
+            inputCsrGains.assign(inputCsr.inputs.size(), nullptr);
+            for (auto& [node, gains] : inputGains) {
+                int begin = inputCsr.begin(nodeIndex.at(node));
+                std::copy(gains.begin(), gains.end(), inputCsrGains.begin() + begin);
+            }
+        }
+    }
+
+    int nodeCount = static_cast<int>(nodes.size());
+
+    // transpose inputCsr (consumer -> inputs) into producer -> consumers
+    std::vector<int> pendingInputs(nodeCount, 0);
+    std::vector<int> consumerOffsets(nodeCount + 1, 0);
+    for (int node = 0; node < nodeCount; node++) {
+        pendingInputs[node] = inputCsr.count(node);
+        for (int e = inputCsr.begin(node); e < inputCsr.end(node); e++) {
+            consumerOffsets[inputCsr.inputs[e] + 1]++;
+        }
+    }
+    for (int i = 0; i < nodeCount; i++) {
+        consumerOffsets[i + 1] += consumerOffsets[i];
+    }
+    std::vector<int> consumers(consumerOffsets.back());
+    std::vector<int> cursor(consumerOffsets.begin(), consumerOffsets.end() - 1);
+    for (int node = 0; node < nodeCount; node++) {
+        for (int e = inputCsr.begin(node); e < inputCsr.end(node); e++) {
+            consumers[cursor[inputCsr.inputs[e]]++] = node;
+        }
+    }
+
+    // Kahn's algorithm, one level at a time
+    // - a node lands in level L when its farthest upstream path from a 0 input node has length L
+    schedule.levelOffsets.clear();
+    schedule.nodeIndices.clear();
+    schedule.nodeIndices.reserve(nodeCount);
+    schedule.levelOffsets.emplace_back(0);
+
+    for (int i = 0; i < nodeCount; i++) {
+        if (pendingInputs[i] == 0) {
+            schedule.nodeIndices.emplace_back(i);
+        }
+    }
+
+    size_t levelBegin = 0;
+    while (levelBegin < schedule.nodeIndices.size()) {
+        size_t levelEnd = schedule.nodeIndices.size();
+        schedule.levelOffsets.emplace_back(static_cast<int>(levelEnd));
+        for (size_t i = levelBegin; i < levelEnd; i++) {
+            int producer = schedule.nodeIndices[i];
+            for (int c = consumerOffsets[producer]; c < consumerOffsets[producer + 1]; c++) {
+                if (--pendingInputs[consumers[c]] == 0) {
+                    schedule.nodeIndices.emplace_back(consumers[c]);
+                }
+            }
+        }
+        levelBegin = levelEnd;
+    }
+
+    if (static_cast<int>(schedule.nodeIndices.size()) != nodeCount) {
+        throw std::runtime_error("Graph::prepare: the graph contains a cycle");
+    }
+
+    if (!arena.empty()) {
+        std::vector<AbstractNode*> order;
+        order.reserve(schedule.nodeIndices.size());
+        for (int index : schedule.nodeIndices) {
+            order.emplace_back(nodes[index]);
+        }
+        relocate(arena.layout(order));
+    }
+    // the CSRs are index based and survive relocation, only the pointer lookup changes
+    nodeIndex.clear();
+    nodeIndex.reserve(nodeCount);
+    for (int i = 0; i < nodeCount; i++) {
+        nodeIndex[nodes[i]] = i;
+    }
+
+    // edges may have changed since the sinks were registered
+    demandCounts.clear();
+    for (auto& [sink, active] : sinks) {
+        if (active) {
+            updateDemand(sink, 1);
+        }
+    }
+}
+
+void Graph::addSink(AbstractNode* node) {
+    if (sinks.try_emplace(node, true).second) {
+        updateDemand(node, 1);
+    }
+}
+
+int Graph::setSinkActive(AbstractNode* node, bool active) {
+    bool& current = sinks.at(node);
+    if (current == active) {
+        return 0;
+    }
+    current = active;
+    return updateDemand(node, active ? 1 : -1);
+}
+
+bool Graph::isDemanded(AbstractNode* node) const {
+    if (sinks.empty()) {
+        return true;
+    }
+    auto count = demandCounts.find(node);
+    return count != demandCounts.end() && count->second > 0;
+}
+
+int Graph::updateDemand(AbstractNode* sink, int delta) {
+    // not prepared since the last node change: prepare() counts every active sink again
+    auto sinkIndex = nodeIndex.find(sink);
+    if (sinkIndex == nodeIndex.end() || inputCsr.offsets.size() != nodes.size() + 1) {
+        return 0;
+    }
+
+    // depth first over consumer -> inputs, each node of the cone counted once per sink
+    std::vector<char> visited(nodes.size(), 0);
+    std::vector<int> pending { sinkIndex->second };
+    visited[sinkIndex->second] = 1;
+    int switched = 0;
+    while (!pending.empty()) {
+        int node = pending.back();
+        pending.pop_back();
+
+        int& count = demandCounts[nodes[node]];
+        bool wasDemanded = count > 0;
+        count += delta;
+        if ((count > 0) != wasDemanded) {
+            switched++;
+        }
+
+        for (auto adjacency : { &inputCsr, &feedbackCsr }) {
+            for (int e = adjacency->begin(node); e < adjacency->end(node); e++) {
+                int input = adjacency->inputs[e];
+                if (!visited[input]) {
+                    visited[input] = 1;
+                    pending.emplace_back(input);
+                }
+            }
+        }
+    }
+    return switched;
+}
+
+EdgeGain* Graph::edgeGain(AbstractNode* sourceNode, AbstractNode* destinationNode) const {
+    // GraphBuilder / loadGraph graphs only have the CSR
+    if (adjacencyFromCsr) {
+        auto source = nodeIndex.find(sourceNode);
+        auto destination = nodeIndex.find(destinationNode);
+        if (inputCsrGains.empty() || source == nodeIndex.end() || destination == nodeIndex.end()) {
+            return nullptr;
+        }
+        for (int e = inputCsr.begin(destination->second); e < inputCsr.end(destination->second); e++) {
+            if (inputCsrGains[e] != nullptr && inputCsr.inputs[e] == source->second) {
+                return inputCsrGains[e];
+            }
+        }
+        return nullptr;
+    }
+
+    auto gains = inputGains.find(destinationNode);
+    if (gains == inputGains.end()) {
+        return nullptr;
+    }
+    const std::vector<AbstractNode*>& inputs = nodeAdjacencyMap.at(destinationNode);
+    for (size_t i = 0; i < gains->second.size(); i++) {
+        if (gains->second[i] != nullptr && inputs[i] == sourceNode) {
+            return gains->second[i];
+        }
+    }
+    return nullptr;
+}
+
+void Graph::relocate(const std::unordered_map<AbstractNode*, AbstractNode*>& relocated) {
+    auto moved = [&relocated](AbstractNode* node) {
+        auto entry = relocated.find(node);
+        return entry == relocated.end() ? node : entry->second;
+    };
+    auto relocateAdjacency = [&moved](std::map<AbstractNode*, std::vector<AbstractNode*>>& adjacency) {
+        std::map<AbstractNode*, std::vector<AbstractNode*>> updated;
+        for (auto& [node, inputs] : adjacency) {
+            for (auto& input : inputs) {
+                input = moved(input);
+            }
+            updated.emplace(moved(node), std::move(inputs));
+        }
+        adjacency = std::move(updated);
+    };
+
+    for (auto& node : nodes) {
+        node = moved(node);
+    }
+    std::map<AbstractNode*, bool> updatedSinks;
+    for (auto& [sink, active] : sinks) {
+        updatedSinks.emplace(moved(sink), active);
+    }
+    sinks = std::move(updatedSinks);
+    relocateAdjacency(nodeAdjacencyMap);
+    relocateAdjacency(feedbackAdjacencyMap);
+
+    std::map<AbstractNode*, NodeBinding> updatedBindings;
+    for (auto& [node, binding] : bindings) {
+        updatedBindings.emplace(moved(node), binding);
+    }
+    bindings = std::move(updatedBindings);
+
+    std::map<AbstractNode*, std::vector<EdgeGain*>> updatedGains;
+    for (auto& [node, gains] : inputGains) {
+        updatedGains.emplace(moved(node), std::move(gains));
+    }
+    inputGains = std::move(updatedGains);
+
+    // ports and instance lambdas hold the old addresses, resolve them again through the bindings
+    std::map<AbstractNode*, TypeMapPorts> updatedPorts;
+    for (auto& [node, ports] : typeMapPorts) {
+        AbstractNode* current = moved(node);
+        TypeMapPorts& resolved = updatedPorts[current];
+        resolved.input = bindings.at(current).asInput(current);
+        for (auto input : nodeAdjacencyMap[current]) {
+            resolved.outputs.emplace_back(bindings.at(input).asOutput(input));
+        }
+        resolved.gains = std::move(ports.gains);
+    }
+    typeMapPorts = std::move(updatedPorts);
+
+    std::map<AbstractNode*, std::function<void()>> updatedInstances;
+    for (auto& [node, instance] : instanceMap) {
+        AbstractNode* current = moved(node);
+        updatedInstances.emplace(current, bindings.at(current).instance(current, typeMapPorts[current]));
+    }
+    instanceMap = std::move(updatedInstances);
+}
+
+void Graph::compile() {
+    // the previous plan's partial sums live on in its copies, only their bindings go
+    for (auto& partial : plan.partialSums) {
+        bindings.erase(partial.get());
+    }
+    plan.partialSums.clear();
+    plan.steps.clear();
+    plan.constantSteps.clear();
+    plan.chainSteps.clear();
+    plan.edges.clear();
+    plan.feedbackSources.clear();
+    plan.steps.reserve(schedule.nodeIndices.size());
+    plan.levelOffsets.assign(1, 0);
+
+    int nodeCount = static_cast<int>(nodes.size());
+    if (inputCsr.offsets.size() != nodes.size() + 1) {
+        throw std::runtime_error("Graph::compile: nodes changed since prepare()");
+    }
+
+    // one binding lookup per node, everything below works on indices
+    std::vector<const NodeBinding*> bindingOf(nodeCount);
+    for (int i = 0; i < nodeCount; i++) {
+        auto binding = bindings.find(nodes[i]);
+        if (binding == bindings.end()) {
+            throw std::runtime_error("Graph::compile: no binding for node " + nodes[i]->name);
+        }
+        bindingOf[i] = &binding->second;
+    }
+
+    // pruning: keep the demanded nodes of every level, drop levels that end up empty
+    // - a demanded node's inputs are demanded as well, so every edge below stays inside the plan
+    // folding: a node whose output cannot change between ticks leaves the schedule for constantSteps
+    // - constant nodes, and pure nodes whose inputs are all folded and that read no feedback
+    std::vector<int> order;
+    std::vector<int> folded;
+    std::vector<char> isFolded(nodeCount, 0);
+    order.reserve(schedule.nodeIndices.size());
+    auto foldable = [this, &isFolded](int node) {
+        NodePurity purity = nodes[node]->purity();
+        if (!foldConstants || purity == NodePurity::stateful) {
+            return false;
+        }
+        if (purity == NodePurity::constant) {
+            return true;
+        }
+        if (feedbackCsr.count(node) != 0) {
+            return false;
+        }
+        return std::all_of(inputCsr.inputs.begin() + inputCsr.begin(node), inputCsr.inputs.begin() + inputCsr.end(node),
+            [&isFolded](int input) {
+                return isFolded[input] != 0;
+            });
+    };
+    std::vector<int> live;
+    std::vector<int> liveLevelEnds;
+    live.reserve(schedule.nodeIndices.size());
+    for (int level = 0; level < schedule.levelCount(); level++) {
+        for (int i = schedule.levelOffsets[level]; i < schedule.levelOffsets[level + 1]; i++) {
+            int node = schedule.nodeIndices[i];
+            if (!isDemanded(nodes[node])) {
+                continue;
+            }
+            if (foldable(node)) {
+                folded.emplace_back(node);
+                isFolded[node] = 1;
+            } else {
+                live.emplace_back(node);
+            }
+        }
+        liveLevelEnds.emplace_back(static_cast<int>(live.size()));
+    }
+    // only folded nodes raise the plan's flag on markChanged()
+    for (int node = 0; node < nodeCount; node++) {
+        nodes[node]->foldedChanged = isFolded[node] ? plan.constantsChanged.get() : nullptr;
+    }
+
+    // nodes with a weighted input edge
+    std::vector<char> isWeighted(nodeCount, 0);
+    if (!inputCsrGains.empty()) {
+        for (int node = 0; node < nodeCount; node++) {
+            for (int e = inputCsr.begin(node); e < inputCsr.end(node); e++) {
+                if (inputCsrGains[e] != nullptr) {
+                    isWeighted[node] = 1;
+                }
+            }
+            if (isWeighted[node] && nodes[node]->rate().divisor > 1) {
+                throw std::runtime_error("Graph::compile: weighted input edge into control-rate node " + nodes[node]->name);
+            }
+        }
+    }
+
+    // fusion: B runs inside A's step when A is B's only input and B is A's only consumer
+    // - chainNext[A] = B, B leaves the schedule, its consumers depend on the step it was fused into
+    std::vector<int> chainNext(nodeCount, -1);
+    std::vector<char> isChained(nodeCount, 0);
+    if (fuseChains) {
+        std::vector<int> consumerCount(nodeCount, 0);
+        for (int node : live) {
+            for (int e = inputCsr.begin(node); e < inputCsr.end(node); e++) {
+                consumerCount[inputCsr.inputs[e]]++;
+            }
+        }
+        for (int node : live) {
+            if (inputCsr.count(node) != 1 || feedbackCsr.count(node) != 0 || nodes[node]->rate().divisor > 1
+                || isWeighted[node]) {
+                continue;
+            }
+            int input = inputCsr.inputs[inputCsr.begin(node)];
+            if (!isFolded[input] && consumerCount[input] == 1) {
+                chainNext[input] = node;
+                isChained[node] = 1;
+            }
+        }
+    }
+
+    int levelBegin = 0;
+    for (int levelEnd : liveLevelEnds) {
+        for (int i = levelBegin; i < levelEnd; i++) {
+            if (!isChained[live[i]]) {
+                order.emplace_back(live[i]);
+            }
+        }
+        if (static_cast<int>(order.size()) != plan.levelOffsets.back()) {
+            plan.levelOffsets.emplace_back(static_cast<int>(order.size()));
+        }
+        levelBegin = levelEnd;
+    }
+
+    // every live node maps to the step it runs in, fused nodes to the head of their chain
+    std::vector<int> stepOf(nodeCount, -1);
+    for (int step = 0; step < static_cast<int>(order.size()); step++) {
+        for (int link = order[step]; link != -1; link = chainNext[link]) {
+            stepOf[link] = step;
+        }
+    }
+    std::vector<char> committed(nodeCount, 0);
+    // folded inputs are no dependency: their output is already there before the first step runs
+    // neither is the input of a chain link, it runs earlier in the same step
+    std::vector<int> edgeProducer;
+    auto lower = [&](int node, bool chained) {
+        const NodeBinding& binding = *bindingOf[node];
+        CompiledStep step {
+            chained ? binding.runChained : binding.run,
+            chained ? binding.runChainedBlock : binding.runBlock,
+            nodes[node], static_cast<int>(plan.edges.size()), 0, 0
+        };
+        step.rate = nodes[node]->rate();
+        if (step.rate.divisor > 1 && !isFolded[node]) {
+            step.run = binding.runControl;
+            step.runBlock = binding.runControlBlock;
+        }
+        if (isWeighted[node]) {
+            step.run = binding.runWeighted;
+            step.runBlock = binding.runWeightedBlock;
+        }
+        for (int e = inputCsr.begin(node); e < inputCsr.end(node); e++) {
+            int input = inputCsr.inputs[e];
+            plan.edges.emplace_back(bindingOf[input]->edge(nodes[input], false));
+            plan.edges.back().gain = inputCsrGains.empty() ? nullptr : inputCsrGains[e];
+            edgeProducer.emplace_back(chained || isFolded[input] ? -1 : stepOf[input]);
+        }
+        step.inputEnd = static_cast<int>(plan.edges.size());
+
+        for (int e = feedbackCsr.begin(node); e < feedbackCsr.end(node); e++) {
+            int input = feedbackCsr.inputs[e];
+            plan.edges.emplace_back(bindingOf[input]->edge(nodes[input], true));
+            edgeProducer.emplace_back(-1);
+            if (!committed[input]) {
+                committed[input] = 1;
+                plan.feedbackSources.emplace_back(nodes[input]);
+            }
+        }
+        step.feedbackEnd = static_cast<int>(plan.edges.size());
+        return step;
+    };
+
+    for (int node : folded) {
+        plan.constantSteps.emplace_back(lower(node, false));
+    }
+    for (int node : order) {
+        CompiledStep step = lower(node, false);
+        step.chainBegin = static_cast<int>(plan.chainSteps.size());
+        for (int next = chainNext[node]; next != -1; next = chainNext[next]) {
+            plan.chainSteps.emplace_back(lower(next, true));
+        }
+        step.chainEnd = static_cast<int>(plan.chainSteps.size());
+        plan.steps.emplace_back(step);
+    }
+
+    if (reduceFanIn > 0) {
+        reduceWideSteps(edgeProducer);
+    }
+
+    // step-level dependencies, one per input edge with a producer step
+    int stepCount = static_cast<int>(plan.steps.size());
+    plan.dependencyCounts.assign(stepCount, 0);
+    plan.consumerOffsets.assign(stepCount + 1, 0);
+    for (int i = 0; i < stepCount; i++) {
+        for (int e = plan.steps[i].inputBegin; e < plan.steps[i].inputEnd; e++) {
+            if (edgeProducer[e] >= 0) {
+                plan.consumerOffsets[edgeProducer[e] + 1]++;
+                plan.dependencyCounts[i]++;
+            }
+        }
+    }
+    for (int i = 0; i < stepCount; i++) {
+        plan.consumerOffsets[i + 1] += plan.consumerOffsets[i];
+    }
+    plan.consumers.resize(plan.consumerOffsets.back());
+    std::vector<int> cursor(plan.consumerOffsets.begin(), plan.consumerOffsets.end() - 1);
+    for (int i = 0; i < stepCount; i++) {
+        for (int e = plan.steps[i].inputBegin; e < plan.steps[i].inputEnd; e++) {
+            if (edgeProducer[e] >= 0) {
+                plan.consumers[cursor[edgeProducer[e]]++] = i;
+            }
+        }
+    }
+
+    plan.refreshConstants();
+}
+
+void Graph::reduceWideSteps(std::vector<int>& edgeProducer) {
+    int leafSize = std::max(2, reduceLeafSize);
+    std::vector<CompiledStep> oldSteps = std::move(plan.steps);
+    std::vector<int> oldLevelOffsets = std::move(plan.levelOffsets);
+    std::vector<int> newIndex(oldSteps.size(), -1);
+    plan.steps.clear();
+    plan.steps.reserve(oldSteps.size());
+    plan.levelOffsets.assign(1, 0);
+
+    // a partial sum step over edges [begin, end), its producers already in new step indices
+    auto addPartial = [this](const CompiledStep& wide, int begin, int end) {
+        CompiledStep partial = bindings.at(wide.node).partialSum(*this, wide.node->name + "/sum");
+        partial.inputBegin = begin;
+        partial.inputEnd = end;
+        partial.feedbackEnd = end;
+        plan.steps.emplace_back(partial);
+        return static_cast<int>(plan.steps.size()) - 1;
+    };
+    auto appendEdge = [this, &edgeProducer](PlanEdge edge, int producer) {
+        plan.edges.emplace_back(edge);
+        edgeProducer.emplace_back(producer);
+    };
+    auto closeLevel = [this] {
+        if (static_cast<int>(plan.steps.size()) != plan.levelOffsets.back()) {
+            plan.levelOffsets.emplace_back(static_cast<int>(plan.steps.size()));
+        }
+    };
+
+    for (int level = 0; level + 1 < static_cast<int>(oldLevelOffsets.size()); level++) {
+        // the leaves read the wide step's own edges in place, its producers all sit in earlier levels
+        std::vector<int> wide;
+        std::vector<std::vector<int>> partials;
+        for (int step = oldLevelOffsets[level]; step < oldLevelOffsets[level + 1]; step++) {
+            const CompiledStep& compiled = oldSteps[step];
+            if (compiled.inputEnd - compiled.inputBegin <= reduceFanIn) {
+                continue;
+            }
+            for (int e = compiled.inputBegin; e < compiled.inputEnd; e++) {
+                if (edgeProducer[e] >= 0) {
+                    edgeProducer[e] = newIndex[edgeProducer[e]];
+                }
+            }
+            wide.emplace_back(step);
+            partials.emplace_back();
+            for (int begin = compiled.inputBegin; begin < compiled.inputEnd; begin += leafSize) {
+                partials.back().emplace_back(addPartial(compiled, begin, std::min(begin + leafSize, compiled.inputEnd)));
+            }
+        }
+        closeLevel();
+
+        // pairs of neighbours until every wide step is down to two partials, an odd last one moves up as it is
+        bool pairing = true;
+        while (pairing) {
+            pairing = false;
+            for (size_t w = 0; w < wide.size(); w++) {
+                std::vector<int>& current = partials[w];
+                if (current.size() <= 2) {
+                    continue;
+                }
+                pairing = true;
+                std::vector<int> next;
+                for (size_t i = 0; i < current.size(); i += 2) {
+                    if (i + 1 == current.size()) {
+                        next.emplace_back(current[i]);
+                        continue;
+                    }
+                    int begin = static_cast<int>(plan.edges.size());
+                    for (int child : { current[i], current[i + 1] }) {
+                        AbstractNode* node = plan.steps[child].node;
+                        appendEdge(bindings.at(node).edge(node, false), child);
+                    }
+                    next.emplace_back(addPartial(oldSteps[wide[w]], begin, begin + 2));
+                }
+                current = std::move(next);
+            }
+            closeLevel();
+        }
+
+        // the wide steps read their top partials, followed by a copy of their feedback edges
+        size_t w = 0;
+        for (int step = oldLevelOffsets[level]; step < oldLevelOffsets[level + 1]; step++) {
+            CompiledStep compiled = oldSteps[step];
+            if (w < wide.size() && wide[w] == step) {
+                int begin = static_cast<int>(plan.edges.size());
+                for (int partial : partials[w]) {
+                    AbstractNode* node = plan.steps[partial].node;
+                    appendEdge(bindings.at(node).edge(node, false), partial);
+                }
+                int inputEnd = static_cast<int>(plan.edges.size());
+                for (int e = compiled.inputEnd; e < compiled.feedbackEnd; e++) {
+                    appendEdge(PlanEdge(plan.edges[e]), -1);
+                }
+                compiled.inputBegin = begin;
+                compiled.inputEnd = inputEnd;
+                compiled.feedbackEnd = static_cast<int>(plan.edges.size());
+                w++;
+            } else {
+                for (int e = compiled.inputBegin; e < compiled.inputEnd; e++) {
+                    if (edgeProducer[e] >= 0) {
+                        edgeProducer[e] = newIndex[edgeProducer[e]];
+                    }
+                }
+            }
+            newIndex[step] = static_cast<int>(plan.steps.size());
+            plan.steps.emplace_back(compiled);
+        }
+        closeLevel();
+    }
+}
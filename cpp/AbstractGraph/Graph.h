@@ -1,11 +1,343 @@
 #pragma once
+#include <algorithm>
+#include <atomic>
 #include <vector>
 #include <functional>
 #include <map>
+#include <memory>
+#include <unordered_map>
+#include <utility>
 
 #include "FrameBase.h"
+#include "NodeArena.h"
 #include "NodeBase.h"
 
+// flat, level-ordered schedule produced by Graph::prepare()
+// - level L covers nodeIndices[levelOffsets[L] .. levelOffsets[L + 1])
+// - node indices refer to Graph::nodes
+struct Schedule {
+    std::vector<int> levelOffsets;
+    std::vector<int> nodeIndices;
+
+    int levelCount() const {
+        return levelOffsets.empty() ? 0 : static_cast<int>(levelOffsets.size()) - 1;
+    }
+};
+
+// consumer -> inputs over node indices, compressed sparse row
+// - inputs of node i are inputs[offsets[i] .. offsets[i + 1]), in the order they were connected
+// - node indices refer to Graph::nodes
+struct AdjacencyCsr {
+    std::vector<int> offsets;
+    std::vector<int> inputs;
+
+    int begin(int node) const {
+        return offsets[node];
+    }
+
+    int end(int node) const {
+        return offsets[node + 1];
+    }
+
+    int count(int node) const {
+        return offsets[node + 1] - offsets[node];
+    }
+
+    // counting sort of (source, destination) pairs by destination, O(V + E)
+    static AdjacencyCsr fromEdges(int nodeCount, const std::vector<std::pair<int, int>>& edges);
+};
+
+// ----------------
+// Compiled plan
+// the gain of a weighted edge, see Graph::connect(source, destination, gain)
+// - set() from any thread; the consumer's next block ramps linearly from the gain it last used to the new one,
+//   a single sample takes the new gain at once
+// - current is only touched by the step reading the edge
+struct EdgeGain {
+    explicit EdgeGain(float gain) : target(gain), current(gain) { }
+
+    void set(float gain) {
+        target.store(gain, std::memory_order_relaxed);
+    }
+
+    float get() const {
+        return target.load(std::memory_order_relaxed);
+    }
+
+    std::atomic<float> target;
+    float current;
+};
+
+// a provider's output as one consumer reads it, resolved once by compile()
+// - frame: the provider's lastOutput (previous output for feedback edges), read by const reference
+// - block: the provider's current (previous) block slot, dereferenced on every read since slots flip
+// - gain: nullptr for a plain edge, see accumulateScaled()
+struct PlanEdge {
+    const void* frame;
+    const void* block;
+    EdgeGain* gain = nullptr;
+
+    template <Frame T>
+    const T& viewFrame() const {
+        return *static_cast<const T*>(frame);
+    }
+
+    template <Frame T>
+    const T* viewBlock() const {
+        return *static_cast<const T* const*>(block);
+    }
+};
+
+// frame += gain * edge, for a weighted edge
+template <ScalableFrame T>
+void accumulateScaled(T& frame, const PlanEdge& edge) {
+    edge.gain->current = edge.gain->get();
+    frame.addScaled(edge.viewFrame<T>(), edge.gain->current);
+}
+
+// frame += gain * input for the type map / instance map, frame += input for a plain edge (gain nullptr)
+// - they run sample by sample, so like single samples in the plan they take the gain's target at once
+template <Frame T>
+void accumulateInput(T& frame, const T& input, const EdgeGain* gain) {
+    if constexpr (ScalableFrame<T>) {
+        if (gain != nullptr) {
+            frame.addScaled(input, gain->get());
+            return;
+        }
+    }
+    frame += input;
+}
+
+// output[s] += gain * edge[s] over a block, the gain ramping from the one used last to its target
+// - one fused multiply-add per sample either way, a constant gain keeps the loop free of the ramp
+template <ScalableFrame T>
+void accumulateScaledBlock(T* output, const PlanEdge& edge, int count) {
+    const T* block = edge.viewBlock<T>();
+    float from = edge.gain->current;
+    float to = edge.gain->get();
+    if (from == to) {
+        for (int s = 0; s < count; s++) {
+            output[s].addScaled(block[s], to);
+        }
+        return;
+    }
+    float step = (to - from) / static_cast<float>(count);
+    for (int s = 0; s < count; s++) {
+        output[s].addScaled(block[s], from + step * static_cast<float>(s + 1));
+    }
+    edge.gain->current = to;
+}
+
+// ring of a producer's output blocks, for readers running a fixed number of blocks behind it, see PipelineExecutor
+// - push(tick, count) copies the producer's current block into the ring entry of that tick
+// - advance(tick) points readSlot(lag) at the block pushed `lag` ticks earlier, call it between ticks
+// - readSlot(lag) is a block slot like Node::currentBlockSlot(), a PlanEdge can point at it
+struct AbstractBlockQueue {
+    virtual ~AbstractBlockQueue() = default;
+    virtual void push(int tick, int count) = 0;
+    virtual void advance(int tick) = 0;
+    virtual const void* readSlot(int lag) const = 0;
+};
+
+template <Frame T>
+struct BlockQueue : public AbstractBlockQueue {
+    BlockQueue(NodeOutput<T>* producer, int maxLag, int maxBlockSize)
+        : producer(producer), ring(maxLag + 1, std::vector<T>(maxBlockSize)), slots(maxLag + 1, nullptr) { }
+
+    void push(int tick, int count) override {
+        const T* block = producer->getBlock();
+        std::copy(block, block + count, ring[tick % ring.size()].begin());
+    }
+
+    void advance(int tick) override {
+        int size = static_cast<int>(ring.size());
+        for (int lag = 1; lag < size; lag++) {
+            slots[lag] = ring[((tick - lag) % size + size) % size].data();
+        }
+    }
+
+    const void* readSlot(int lag) const override {
+        return &slots[lag];
+    }
+
+    NodeOutput<T>* producer;
+    std::vector<std::vector<T>> ring;
+    std::vector<const T*> slots;
+};
+
+struct CompiledStep;
+using StepFunction = void (*)(const CompiledStep& step, const PlanEdge* edges);
+using BlockStepFunction = void (*)(const CompiledStep& step, const PlanEdge* edges, int count);
+
+// one node of the compiled plan
+// - edges[inputBegin .. inputEnd) are the node's inputs
+// - edges[inputEnd .. feedbackEnd) are feedback inputs, read from the producer's previous tick/block
+// - chainSteps[chainBegin .. chainEnd) are nodes fused behind this one, run right after it in the same dispatch
+// - rate: the node's NodeRate, cached for control-rate step functions
+struct CompiledStep {
+    StepFunction run;
+    BlockStepFunction runBlock;
+    AbstractNode* node;
+    int inputBegin;
+    int inputEnd;
+    int feedbackEnd;
+    int chainBegin = 0;
+    int chainEnd = 0;
+    NodeRate rate {};
+};
+
+// the graph lowered into one contiguous array of steps, in schedule order
+// - all steps share a single edge array
+// - levelOffsets mirror Schedule::levelOffsets, indexing into steps
+// - dependencyCounts / consumers are step-level dependencies for dataflow executors
+//   step i feeds steps consumers[consumerOffsets[i] .. consumerOffsets[i + 1]), one entry per edge
+// - feedback edges are not dependencies, feedbackSources are committed once at the end of every tick/block
+// - constantSteps are folded out of the schedule, run once by refreshConstants()
+//   and again when a folded node calls AbstractNode::markChanged(), see refreshChangedConstants()
+// - chainSteps are fused into the step in front of them, see Graph::fuseChains
+// - partialSums are the nodes of the partial sum steps, see Graph::reduceFanIn; copies of the plan share them
+struct ExecutionPlan {
+    std::vector<CompiledStep> steps;
+    std::vector<CompiledStep> constantSteps;
+    std::vector<CompiledStep> chainSteps;
+    std::vector<PlanEdge> edges;
+    std::vector<int> levelOffsets;
+    std::vector<int> dependencyCounts;
+    std::vector<int> consumerOffsets;
+    std::vector<int> consumers;
+    std::vector<AbstractNode*> feedbackSources;
+    std::vector<std::shared_ptr<AbstractNode>> partialSums;
+    // raised by folded nodes, shared with the plan's copies and kept over compile()
+    std::shared_ptr<std::atomic<bool>> constantsChanged = std::make_shared<std::atomic<bool>>(false);
+
+    // count == 0 runs one sample, otherwise one block of count samples
+    void runStep(int index, int count) const {
+        const CompiledStep& step = steps[index];
+        if (count == 0) {
+            step.run(step, edges.data());
+        } else {
+            step.runBlock(step, edges.data(), count);
+        }
+        runChain(step, count);
+    }
+
+    void runChain(const CompiledStep& step, int count) const {
+        const PlanEdge* edgeData = edges.data();
+        for (int i = step.chainBegin; i < step.chainEnd; i++) {
+            const CompiledStep& link = chainSteps[i];
+            if (count == 0) {
+                link.run(link, edgeData);
+            } else {
+                link.runBlock(link, edgeData, count);
+            }
+        }
+    }
+
+    // evaluates the folded steps once and holds their output over both block slots
+    // - compile() and Graph::prepareBlock() call this
+    void refreshConstants() const {
+        constantsChanged->store(false, std::memory_order_relaxed);
+        const PlanEdge* edgeData = edges.data();
+        for (const CompiledStep& step : constantSteps) {
+            step.run(step, edgeData);
+            step.node->holdOutput();
+        }
+    }
+
+    // refolds if a folded node was marked changed, run() / runBlock() and every executor call this before a tick/block
+    // - a plain load while nothing changed, so the per-sample run() stays cheap
+    void refreshChangedConstants() const {
+        if (constantsChanged->load(std::memory_order_relaxed)
+            && constantsChanged->exchange(false, std::memory_order_acquire)) {
+            refreshConstants();
+        }
+    }
+
+    // every executor calls this after the last step of a tick/block
+    void commitFeedback(int count) const {
+        for (auto node : feedbackSources) {
+            node->commitOutput(count);
+        }
+    }
+
+    void run() const {
+        refreshChangedConstants();
+        const PlanEdge* edgeData = edges.data();
+        for (const CompiledStep& step : steps) {
+            step.run(step, edgeData);
+            runChain(step, 0);
+        }
+        commitFeedback(0);
+    }
+
+    // one dispatch per node per block
+    // - count must not exceed the size given to Graph::prepareBlock()
+    void runBlock(int count) const {
+        refreshChangedConstants();
+        const PlanEdge* edgeData = edges.data();
+        for (const CompiledStep& step : steps) {
+            step.runBlock(step, edgeData, count);
+            runChain(step, count);
+        }
+        commitFeedback(count);
+    }
+};
+
+// a partial sum of a wide step's inputs, see Graph::reduceFanIn
+// - made by compile(), never in Graph::nodes
+// - adds its edges straight into its output in edge order: no input block, no tick
+// - the leaves read the wide step's own edges, weighted ones included
+template <Frame T>
+struct PartialSumNode : public Node<T, T> {
+    using Node<T, T>::Node;
+
+    T tick(const T& input) override {
+        return input;
+    }
+
+    void sum(const PlanEdge* edges, int edgeCount) {
+        T frame;
+        for (int i = 0; i < edgeCount; i++) {
+            if constexpr (ScalableFrame<T>) {
+                if (edges[i].gain != nullptr) {
+                    accumulateScaled(frame, edges[i]);
+                    continue;
+                }
+            }
+            frame += edges[i].viewFrame<T>();
+        }
+        this->lastOutput = frame;
+    }
+
+    // a plain first block is copied instead of added to a cleared one, same result, one pass less
+    void sumBlock(const PlanEdge* edges, int edgeCount, int count) {
+        T* output = this->currentBlock;
+        int i = 0;
+        if (edges[0].gain == nullptr) {
+            const T* first = edges[0].viewBlock<T>();
+            std::copy(first, first + count, output);
+            i = 1;
+        } else {
+            for (int s = 0; s < count; s++) {
+                output[s].reset();
+            }
+        }
+        for (; i < edgeCount; i++) {
+            if constexpr (ScalableFrame<T>) {
+                if (edges[i].gain != nullptr) {
+                    accumulateScaledBlock(output, edges[i], count);
+                    continue;
+                }
+            }
+            const T* block = edges[i].viewBlock<T>();
+            for (int s = 0; s < count; s++) {
+                output[s] += block[s];
+            }
+        }
+        this->lastOutput = output[count - 1];
+    }
+};
+
 struct Graph {
     Graph() {
         if (Graph::context == nullptr) {
@@ -13,40 +345,98 @@ struct Graph {
         } 
     }
 
+    ~Graph() {
+        if (Graph::context == this) {
+            Graph::context = nullptr;
+        }
+    }
+
     // ----------------
     // Context
-    static Graph* context;
+    // the graph operator>> / operator>>= wire into, one per thread
+    // - a graph becomes its thread's context when constructed while the thread has none, or with setContext()
+    // - graphs built on different threads never see each other's context, connect() skips it entirely
+    static thread_local Graph* context;
     void setContext() {
         Graph::context = this;
     }
 
+    // makes `graph` the thread's context for a scope, restores the previous one
+    struct ContextScope {
+        explicit ContextScope(Graph& graph) : previous(Graph::context) {
+            Graph::context = &graph;
+        }
+        ~ContextScope() {
+            Graph::context = previous;
+        }
+        Graph* previous;
+    };
+
+    // ----------------
+    // Edges
+    // explicit handle: what operator>> / operator>>= do on the thread's context
+    template <Frame X, Frame Y, Frame Z>
+    void connect(Node<X,Y>& sourceNode, Node<Y,Z>& destinationNode);
+
+    template <Frame X, Frame Y, Frame Z>
+    void connectFeedback(Node<X,Y>& sourceNode, Node<Y,Z>& destinationNode);
+
+    // weighted edge: destinationNode reads gain * sourceNode, what `sourceNode * gain >> destinationNode` does
+    // - every weighted connect is an edge of its own with its own EdgeGain, also between the same two nodes
+    // - the returned gain stays valid for the graph's lifetime
+    // - the compiled plan ramps a changed gain over the next block, type map / instance map apply it per sample
+    template <Frame X, ScalableFrame Y, Frame Z>
+    EdgeGain& connect(Node<X,Y>& sourceNode, Node<Y,Z>& destinationNode, float gain);
+
+    // the gain of the first weighted edge from sourceNode into destinationNode, nullptr when there is none
+    EdgeGain* edgeGain(AbstractNode* sourceNode, AbstractNode* destinationNode) const;
+
     // ----------------
     // Type lambdas
+    // typed port handles, resolved once by operator>> with plain upcasts
+    // - input:   the node as NodeInput<F>*, F being its input frame type
+    // - outputs: every provider as NodeOutput<F>*
+    // - gains:   the EdgeGain of each output, same order, nullptr for plain edges; may be shorter than outputs
+    struct TypeMapPorts {
+        void* input = nullptr;
+        std::vector<void*> outputs;
+        std::vector<EdgeGain*> gains;
+    };
+
     template<Frame FrameType>
-    static std::function<void(AbstractNode*, std::vector<AbstractNode*>&)>
-        CreateTypeMapFunction(NodeInput<FrameType> *receivingNode) {
-        return [](AbstractNode* node, std::vector<AbstractNode*> inputs) {
-            // bulk-casting here is 16% slower vs. cast per in for loop
+    static std::function<void(TypeMapPorts&)> CreateTypeMapFunction() {
+        return [](TypeMapPorts& ports) {
             FrameType frame {};
-            for (auto input : inputs) {
-                NodeOutput<FrameType>* providingNode = dynamic_cast<NodeOutput<FrameType>*>(input);
-                frame += providingNode->getResult();
+            for (size_t i = 0; i < ports.outputs.size(); i++) {
+                const EdgeGain* gain = i < ports.gains.size() ? ports.gains[i] : nullptr;
+                accumulateInput(frame, static_cast<NodeOutput<FrameType>*>(ports.outputs[i])->getResult(), gain);
             }
-            NodeInput<FrameType> *receivingNode = dynamic_cast<NodeInput<FrameType>*>(node);
-            receivingNode->processNext(frame);
+            static_cast<NodeInput<FrameType>*>(ports.input)->processNext(frame);
         };
     }
 
+    template<Frame FrameType>
+    void registerTypeMapFunction() {
+        size_t id = frameTypeId<FrameType>();
+        if (id >= typeMap.size()) {
+            typeMap.resize(id + 1);
+        }
+        if (!typeMap[id]) {
+            typeMap[id] = CreateTypeMapFunction<FrameType>();
+        }
+    }
+
     // ----------------
     // Instance lambdas
     template<Frame FrameType>
     static std::function<void()>
-        InstanceMap(NodeInput<FrameType>* node, std::vector<NodeOutput<FrameType>*> inputs) {
+        InstanceMap(NodeInput<FrameType>* node, std::vector<NodeOutput<FrameType>*> inputs, std::vector<EdgeGain*> gains = {}) {
 
-        return [node, inputs]() {
+        gains.resize(inputs.size(), nullptr);
+        return [node, inputs, gains]() {
             FrameType frame;
-            for (auto input : inputs) {
-                frame += input->getResult();
+            for (size_t i = 0; i < inputs.size(); i++) {
+                accumulateInput(frame, inputs[i]->getResult(), gains[i]);
             }
             node->processNext(frame);
         };
@@ -54,20 +444,386 @@ struct Graph {
 
     template<Frame FrameType>
     static std::function<void()>
-        InstanceMap(NodeInput<FrameType>* node, std::vector<AbstractNode*> inputs) {
+        InstanceMap(NodeInput<FrameType>* node, const TypeMapPorts& ports) {
         std::vector<NodeOutput<FrameType>*> cast_inputs;
-        for (auto input : inputs) {
-            cast_inputs.emplace_back(dynamic_cast<NodeOutput<FrameType>*>(input));
+        for (auto output : ports.outputs) {
+            cast_inputs.emplace_back(static_cast<NodeOutput<FrameType>*>(output));
         }
 
-        return InstanceMap(node, cast_inputs);
+        return InstanceMap(node, cast_inputs, ports.gains);
+    }
+
+    // ----------------
+    // Sorting
+    // a modified topological sort
+    // - nodes are grouped into "distance from outside edge"
+    // - "outside edge" refers to the farthest upstream node with 0 inputs
+    // - runs in O(V + E) over inputCsr, built from nodeAdjacencyMap unless a GraphBuilder supplied it
+    // - then moves every node owned by the graph into schedule order, see emplace()
+    void prepare();
+
+    // ----------------
+    // Node storage
+    // - the graph owns the node, prepare() relocates owned nodes into one buffer in schedule order
+    // - the returned reference is only valid until prepare(), use Graph::nodes afterwards
+    template <typename NodeT>
+    NodeT& emplace(const char* name) {
+        NodeT* node = arena.emplace<NodeT>(name);
+        nodes.emplace_back(node);
+        bind(node);
+        return *node;
+    }
+
+    // ----------------
+    // Compiled step functions
+    // - typed once per node so compile() and the plan never need to know the concrete frame types
+    struct NodeBinding {
+        StepFunction run;
+        BlockStepFunction runBlock;
+        StepFunction runChained;
+        BlockStepFunction runChainedBlock;
+        StepFunction runControl;
+        BlockStepFunction runControlBlock;
+        void* (*asInput)(AbstractNode*);
+        void* (*asOutput)(AbstractNode*);
+        PlanEdge (*edge)(AbstractNode*, bool feedback);
+        std::function<void()> (*instance)(AbstractNode*, const TypeMapPorts&);
+        std::unique_ptr<AbstractBlockQueue> (*blockQueue)(AbstractNode*, int maxLag, int maxBlockSize);
+        CompiledStep (*partialSum)(Graph&, const std::string& name);
+        // nullptr unless the input frame is a ScalableFrame
+        StepFunction runWeighted = nullptr;
+        BlockStepFunction runWeightedBlock = nullptr;
+    };
+
+    // feedback edges read the same way, their PlanEdge already points at the previous output
+    template<Frame InputT, Frame OutputT>
+    static void RunCompiledStep(const CompiledStep& step, const PlanEdge* edges) {
+        auto node = static_cast<Node<InputT, OutputT>*>(step.node);
+        // qualified calls: skip the processNext vtable hop, tick stays virtual
+        if constexpr (ViewableFrame<InputT>) {
+            if (step.feedbackEnd - step.inputBegin == 1) {
+                node->Node<InputT, OutputT>::processNext(edges[step.inputBegin].viewFrame<InputT>());
+                return;
+            }
+        }
+        InputT frame;
+        for (int i = step.inputBegin; i < step.feedbackEnd; i++) {
+            frame += edges[i].viewFrame<InputT>();
+        }
+        node->Node<InputT, OutputT>::processNext(frame);
+    }
+
+    template<Frame InputT, Frame OutputT>
+    static void RunCompiledBlock(const CompiledStep& step, const PlanEdge* edges, int count) {
+        auto node = static_cast<Node<InputT, OutputT>*>(step.node);
+        if constexpr (ViewableFrame<InputT>) {
+            if (step.feedbackEnd - step.inputBegin == 1) {
+                node->processNextBlock(edges[step.inputBegin].viewBlock<InputT>(), count);
+                return;
+            }
+        }
+        InputT* input = node->getInputBlock();
+        for (int s = 0; s < count; s++) {
+            input[s].reset();
+        }
+        for (int i = step.inputBegin; i < step.feedbackEnd; i++) {
+            const InputT* block = edges[i].viewBlock<InputT>();
+            for (int s = 0; s < count; s++) {
+                input[s] += block[s];
+            }
+        }
+        node->processNextBlock(count);
+    }
+
+    // a fused chain link: exactly one input, the node in front of it in the same step
+    // - no accumulator, no input block: reads the predecessor's frame/block in place
+    template<Frame InputT, Frame OutputT>
+    static void RunChainedStep(const CompiledStep& step, const PlanEdge* edges) {
+        auto node = static_cast<Node<InputT, OutputT>*>(step.node);
+        node->Node<InputT, OutputT>::processNext(edges[step.inputBegin].viewFrame<InputT>());
+    }
+
+    template<Frame InputT, Frame OutputT>
+    static void RunChainedBlock(const CompiledStep& step, const PlanEdge* edges, int count) {
+        auto node = static_cast<Node<InputT, OutputT>*>(step.node);
+        node->processNextBlock(edges[step.inputBegin].viewBlock<InputT>(), count);
+    }
+
+    // a node with weighted input edges: plain edges add, weighted ones add scaled, see accumulateScaled()
+    template<ScalableFrame InputT, Frame OutputT>
+    static void RunWeightedStep(const CompiledStep& step, const PlanEdge* edges) {
+        auto node = static_cast<Node<InputT, OutputT>*>(step.node);
+        InputT frame;
+        for (int i = step.inputBegin; i < step.feedbackEnd; i++) {
+            if (edges[i].gain != nullptr) {
+                accumulateScaled(frame, edges[i]);
+            } else {
+                frame += edges[i].viewFrame<InputT>();
+            }
+        }
+        node->Node<InputT, OutputT>::processNext(frame);
+    }
+
+    template<ScalableFrame InputT, Frame OutputT>
+    static void RunWeightedBlock(const CompiledStep& step, const PlanEdge* edges, int count) {
+        auto node = static_cast<Node<InputT, OutputT>*>(step.node);
+        InputT* input = node->getInputBlock();
+        for (int s = 0; s < count; s++) {
+            input[s].reset();
+        }
+        for (int i = step.inputBegin; i < step.feedbackEnd; i++) {
+            if (edges[i].gain != nullptr) {
+                accumulateScaledBlock(input, edges[i], count);
+                continue;
+            }
+            const InputT* block = edges[i].viewBlock<InputT>();
+            for (int s = 0; s < count; s++) {
+                input[s] += block[s];
+            }
+        }
+        node->processNextBlock(count);
+    }
+
+    // a control-rate node: inputs are only gathered on the samples it ticks, see NodeRate
+    template<Frame InputT, Frame OutputT>
+    static void RunControlStep(const CompiledStep& step, const PlanEdge* edges) {
+        auto node = static_cast<Node<InputT, OutputT>*>(step.node);
+        if (node->controlDue()) {
+            InputT frame;
+            for (int i = step.inputBegin; i < step.feedbackEnd; i++) {
+                frame += edges[i].viewFrame<InputT>();
+            }
+            node->tickControl(frame);
+        }
+        node->advanceControl(step.rate);
+    }
+
+    template<Frame InputT, Frame OutputT>
+    static void RunControlBlock(const CompiledStep& step, const PlanEdge* edges, int count) {
+        auto node = static_cast<Node<InputT, OutputT>*>(step.node);
+        node->processControlBlock([&step, edges](int s) {
+            InputT frame;
+            for (int i = step.inputBegin; i < step.feedbackEnd; i++) {
+                frame += edges[i].viewBlock<InputT>()[s];
+            }
+            return frame;
+        }, count, step.rate);
+    }
+
+    template<Frame T>
+    static void RunPartialSumStep(const CompiledStep& step, const PlanEdge* edges) {
+        static_cast<PartialSumNode<T>*>(step.node)->sum(edges + step.inputBegin, step.inputEnd - step.inputBegin);
+    }
+
+    template<Frame T>
+    static void RunPartialSumBlock(const CompiledStep& step, const PlanEdge* edges, int count) {
+        static_cast<PartialSumNode<T>*>(step.node)->sumBlock(edges + step.inputBegin, step.inputEnd - step.inputBegin, count);
+    }
+
+    template<Frame InputT, Frame OutputT>
+    static void* AsInput(AbstractNode* node) {
+        return static_cast<NodeInput<InputT>*>(static_cast<Node<InputT, OutputT>*>(node));
+    }
+
+    template<Frame InputT, Frame OutputT>
+    static void* AsOutput(AbstractNode* node) {
+        return static_cast<NodeOutput<OutputT>*>(static_cast<Node<InputT, OutputT>*>(node));
+    }
+
+    template<Frame InputT, Frame OutputT>
+    static PlanEdge OutputEdge(AbstractNode* node, bool feedback) {
+        auto typed = static_cast<Node<InputT, OutputT>*>(node);
+        if (feedback) {
+            return { &typed->viewPreviousResult(), typed->previousBlockSlot() };
+        }
+        return { &typed->viewResult(), typed->currentBlockSlot() };
+    }
+
+    template<Frame InputT, Frame OutputT>
+    static std::unique_ptr<AbstractBlockQueue> MakeBlockQueue(AbstractNode* node, int maxLag, int maxBlockSize) {
+        auto typed = static_cast<Node<InputT, OutputT>*>(node);
+        return std::make_unique<BlockQueue<OutputT>>(typed->asOutput(), maxLag, maxBlockSize);
+    }
+
+    // a partial sum over the node's input frame, owned by the plan, sized and bound like any other node
+    template<Frame InputT, Frame OutputT>
+    static CompiledStep MakePartialSum(Graph& graph, const std::string& name) {
+        auto partial = std::make_shared<PartialSumNode<InputT>>(name.c_str());
+        if (graph.preparedBlockSize > 0) {
+            partial->prepareBlock(graph.preparedBlockSize);
+        }
+        graph.bind(partial.get());
+        graph.plan.partialSums.emplace_back(partial);
+        return CompiledStep { &RunPartialSumStep<InputT>, &RunPartialSumBlock<InputT>, partial.get(), 0, 0, 0 };
+    }
+
+    template<Frame InputT, Frame OutputT>
+    static std::function<void()> RebindInstance(AbstractNode* node, const TypeMapPorts& ports) {
+        return InstanceMap<InputT>(static_cast<Node<InputT, OutputT>*>(node), ports);
+    }
+
+    template<Frame InputT, Frame OutputT>
+    void bind(Node<InputT, OutputT>* node) {
+        auto [binding, added] = bindings.try_emplace(node, NodeBinding{
+            &RunCompiledStep<InputT, OutputT>,
+            &RunCompiledBlock<InputT, OutputT>,
+            &RunChainedStep<InputT, OutputT>,
+            &RunChainedBlock<InputT, OutputT>,
+            &RunControlStep<InputT, OutputT>,
+            &RunControlBlock<InputT, OutputT>,
+            &AsInput<InputT, OutputT>,
+            &AsOutput<InputT, OutputT>,
+            &OutputEdge<InputT, OutputT>,
+            &RebindInstance<InputT, OutputT>,
+            &MakeBlockQueue<InputT, OutputT>,
+            &MakePartialSum<InputT, OutputT>
+        });
+        if constexpr (ScalableFrame<InputT>) {
+            if (added) {
+                binding->second.runWeighted = &RunWeightedStep<InputT, OutputT>;
+                binding->second.runWeightedBlock = &RunWeightedBlock<InputT, OutputT>;
+            }
+        }
+    }
+
+    // lower the prepared schedule into `plan`
+    // - call after prepare()
+    // - with sinks registered, only nodes demanded by an active sink are lowered
+    // - with foldConstants, constant subgraphs are evaluated once instead of every tick, see NodePurity
+    // - with fuseChains, a node whose only input is a node it is the only consumer of runs inside that node's step
+    // - nodes with a NodeRate divisor above 1 get the control-rate step functions and are never fused behind another
+    // - nodes with a weighted input edge get the weighted step functions and are never fused behind another,
+    //   control-rate nodes can't have one (throws)
+    // - with reduceFanIn > 0, a step with more inputs than that reads them through a tree of partial sum steps:
+    //   leaves add reduceLeafSize consecutive inputs, every tree level above adds neighbouring pairs, the step
+    //   itself adds the last one or two; tree level t runs in the t-th of the new levels in front of the step's level
+    // - the tree only depends on the input count, so the summation order is the same for every executor and
+    //   worker count (but not the one of the serial sum without reduceFanIn)
+    void compile();
+    bool foldConstants = false;
+    bool fuseChains = false;
+    int reduceFanIn = 0;
+    int reduceLeafSize = 16;
+
+    // ----------------
+    // Sinks
+    // demand-driven pruning: a node is demanded when it has a path (normal or feedback edges) to an active sink
+    // - no sinks registered: every node is demanded
+    // - demandCounts[node] = number of active sinks downstream of node, rebuilt by prepare()
+    // - muting/unmuting only walks that sink's upstream cone, compile() again when it returns non-zero
+    void addSink(AbstractNode* node);
+    // returns how many nodes switched between demanded and not demanded
+    int setSinkActive(AbstractNode* node, bool active);
+    bool isDemanded(AbstractNode* node) const;
+
+    // size every node's block buffers, required before plan.runBlock()
+    void prepareBlock(int maxBlockSize) {
+        for (auto node : nodes) {
+            node->prepareBlock(maxBlockSize);
+        }
+        for (auto& partial : plan.partialSums) {
+            partial->prepareBlock(maxBlockSize);
+        }
+        preparedBlockSize = maxBlockSize;
+        plan.refreshConstants();
     }
 
     std::map<AbstractNode*, std::vector<AbstractNode*>> nodeAdjacencyMap;
-    using MapIOFunc = std::function<void(AbstractNode*, std::vector<AbstractNode*>&)>;
-    std::map<std::type_index, MapIOFunc> typeMap;
+    // consumer -> producers whose previous tick/block it reads, ignored by the sort
+    std::map<AbstractNode*, std::vector<AbstractNode*>> feedbackAdjacencyMap;
+    using MapIOFunc = std::function<void(TypeMapPorts&)>;
+    // indexed by frameTypeId of the receiving node's input frame
+    std::vector<MapIOFunc> typeMap;
+    std::map<AbstractNode*, TypeMapPorts> typeMapPorts;
     std::map<AbstractNode*, std::function<void()>> instanceMap;
     std::vector<AbstractNode*> nodes;
-    std::map<int, std::vector<AbstractNode*>> sortedNodes;
+    // AbstractNode* -> index into nodes, valid after prepare()
+    std::unordered_map<AbstractNode*, int> nodeIndex;
+    // index-based copies of the two maps, read by the sort, compile() and the demand walk
+    // - adjacencyFromCsr: a GraphBuilder filled these directly and the maps stay empty
+    AdjacencyCsr inputCsr;
+    AdjacencyCsr feedbackCsr;
+    bool adjacencyFromCsr = false;
+    Schedule schedule;
+    std::map<AbstractNode*, NodeBinding> bindings;
+    // every EdgeGain of the graph, PlanEdge::gain points here
+    std::vector<std::unique_ptr<EdgeGain>> edgeGains;
+    // consumer -> the gain of each of its nodeAdjacencyMap inputs, same order, nullptr for plain edges
+    // - only consumers with a weighted input have an entry, it can be shorter than the inputs: the rest are plain
+    std::map<AbstractNode*, std::vector<EdgeGain*>> inputGains;
+    // the gain of every inputCsr edge, same order, nullptr for plain edges; empty when no edge has a gain
+    std::vector<EdgeGain*> inputCsrGains;
+    ExecutionPlan plan;
+    // sink -> active
+    std::map<AbstractNode*, bool> sinks;
+    std::map<AbstractNode*, int> demandCounts;
+    // the size last given to prepareBlock(), compile() sizes new partial sums to it
+    int preparedBlockSize = 0;
+
+private:
+    // splits the steps wider than reduceFanIn, see compile()
+    // - edgeProducer: the step every edge of plan.edges is a dependency on, -1 for none; kept up to date
+    void reduceWideSteps(std::vector<int>& edgeProducer);
+
+    // adds delta to every node in the sink's upstream cone, returns how many crossed zero
+    int updateDemand(AbstractNode* sink, int delta);
 
+    // swap every graph-side pointer to a relocated node
+    void relocate(const std::unordered_map<AbstractNode*, AbstractNode*>& relocated);
+
+    NodeArena arena;
 };
+
+template <Frame X, Frame Y, Frame Z>
+void Graph::connect(Node<X,Y>& sourceNode, Node<Y,Z>& destinationNode) {
+    nodeAdjacencyMap[&destinationNode].emplace_back(&sourceNode);
+
+    // typed port handles: plain upcasts while the frame types are still known, no RTTI later
+    TypeMapPorts& sourcePorts = typeMapPorts[&sourceNode];
+    sourcePorts.input = static_cast<NodeInput<X>*>(&sourceNode);
+    TypeMapPorts& destinationPorts = typeMapPorts[&destinationNode];
+    destinationPorts.input = static_cast<NodeInput<Y>*>(&destinationNode);
+    destinationPorts.outputs.emplace_back(static_cast<NodeOutput<Y>*>(&sourceNode));
+
+    // type map approach: auto register processing functions
+    registerTypeMapFunction<X>();
+    registerTypeMapFunction<Y>();
+
+    // instance map approach: auto register processing functions
+    // - InstanceMap(...) is capturing the typed adjacency list each time.
+    // - can alternatively move a single iteration of the instance map setup into a graph.prepare() method.
+    
+    if (!instanceMap.contains(&sourceNode)) {
+        instanceMap[&sourceNode] = InstanceMap<X>(&sourceNode, sourcePorts);
+    }
+    instanceMap[&destinationNode] = InstanceMap<Y>(&destinationNode, destinationPorts);
+
+    // compiled plan approach: register the typed step function, the plan itself is built by compile()
+    bind(&sourceNode);
+    bind(&destinationNode);
+}
+
+template <Frame X, ScalableFrame Y, Frame Z>
+EdgeGain& Graph::connect(Node<X,Y>& sourceNode, Node<Y,Z>& destinationNode, float gain) {
+    connect(sourceNode, destinationNode);
+    edgeGains.emplace_back(std::make_unique<EdgeGain>(gain));
+    std::vector<EdgeGain*>& gains = inputGains[&destinationNode];
+    gains.resize(nodeAdjacencyMap[&destinationNode].size(), nullptr);
+    gains.back() = edgeGains.back().get();
+
+    // the ports and the instance lambda connect() just set up read the gain too
+    typeMapPorts[&destinationNode].gains = gains;
+    instanceMap[&destinationNode] = InstanceMap<Y>(&destinationNode, typeMapPorts[&destinationNode]);
+    return *edgeGains.back();
+}
+
+// feedback edge: destinationNode reads sourceNode's previous tick/block
+// - not an edge for the sort or the dependency counters, so loops stay acyclic
+// - only the compiled plan and its executors read feedback, type map / instance map ignore it
+template <Frame X, Frame Y, Frame Z>
+void Graph::connectFeedback(Node<X,Y>& sourceNode, Node<Y,Z>& destinationNode) {
+    feedbackAdjacencyMap[&destinationNode].emplace_back(&sourceNode);
+
+    bind(&sourceNode);
+    bind(&destinationNode);
+}
@@ -0,0 +1,119 @@
+#pragma once
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "FrameBase.h"
+#include "NodeBase.h"
+#include "Graph.h"
+
+// bulk construction in O(V + E)
+// - nodes are referred to by their index in Graph::nodes, edges are appended as (source, destination) index pairs
+// - build() counting-sorts the edges into Graph::inputCsr / feedbackCsr and prepares the graph
+// - the adjacency maps, type map ports and instance lambdas stay empty: the graph runs through compile()
+// - frame types are checked per edge at connect time instead of by the compiler, so is the gain of a weighted edge
+struct GraphBuilder {
+    explicit GraphBuilder(Graph& graph) : graph(graph) {
+        if (!graph.nodes.empty() || !graph.nodeAdjacencyMap.empty() || !graph.feedbackAdjacencyMap.empty()) {
+            throw std::runtime_error("GraphBuilder: graph is not empty");
+        }
+    }
+
+    void reserve(int nodeCount, int edgeCount) {
+        graph.nodes.reserve(nodeCount);
+        edges.reserve(edgeCount);
+    }
+
+    // graph-owned node, see Graph::emplace
+    template <typename NodeT>
+    int emplace(const char* name) {
+        graph.emplace<NodeT>(name);
+        return static_cast<int>(graph.nodes.size()) - 1;
+    }
+
+    // externally owned node
+    template <Frame InputT, Frame OutputT>
+    int add(Node<InputT, OutputT>& node) {
+        graph.nodes.emplace_back(&node);
+        graph.bind(&node);
+        return static_cast<int>(graph.nodes.size()) - 1;
+    }
+
+    // only valid until build(), owned nodes move with prepare()
+    template <typename NodeT>
+    NodeT& node(int index) {
+        return *static_cast<NodeT*>(graph.nodes[index]);
+    }
+
+    void connect(int source, int destination) {
+        check(source, destination);
+        edges.emplace_back(source, destination);
+    }
+
+    // weighted edge, see Graph::connect(source, destination, gain)
+    // - the destination's input frame must be a ScalableFrame
+    EdgeGain& connect(int source, int destination, float gain) {
+        check(source, destination);
+        AbstractNode* destinationNode = graph.nodes[destination];
+        if (graph.bindings.at(destinationNode).runWeighted == nullptr) {
+            throw std::runtime_error("GraphBuilder: input frame of " + destinationNode->name + " can't be scaled");
+        }
+        graph.edgeGains.emplace_back(std::make_unique<EdgeGain>(gain));
+        gains.emplace_back(edges.size(), graph.edgeGains.back().get());
+        edges.emplace_back(source, destination);
+        return *graph.edgeGains.back();
+    }
+
+    void connectFeedback(int source, int destination) {
+        check(source, destination);
+        feedbackEdges.emplace_back(source, destination);
+    }
+
+    // throws on a cycle like Graph::prepare(), compile() next
+    void build() {
+        int nodeCount = static_cast<int>(graph.nodes.size());
+        graph.inputCsr = AdjacencyCsr::fromEdges(nodeCount, edges);
+        graph.feedbackCsr = AdjacencyCsr::fromEdges(nodeCount, feedbackEdges);
+        graph.adjacencyFromCsr = true;
+
+        // the same stable counting pass as fromEdges puts every gain next to its edge
+        graph.inputCsrGains.clear();
+        if (!gains.empty()) {
+            std::vector<int> edgePosition(edges.size());
+            std::vector<int> cursor(graph.inputCsr.offsets.begin(), graph.inputCsr.offsets.end() - 1);
+            for (size_t e = 0; e < edges.size(); e++) {
+                edgePosition[e] = cursor[edges[e].second]++;
+            }
+            graph.inputCsrGains.assign(edges.size(), nullptr);
+            for (auto [edge, gain] : gains) {
+                graph.inputCsrGains[edgePosition[edge]] = gain;
+            }
+        }
+        // fresh vectors hand the memory back, assigning {} would keep the capacity
+        edges = std::vector<std::pair<int, int>>();
+        feedbackEdges = std::vector<std::pair<int, int>>();
+        gains = std::vector<std::pair<size_t, EdgeGain*>>();
+        graph.prepare();
+    }
+
+private:
+    void check(int source, int destination) const {
+        int nodeCount = static_cast<int>(graph.nodes.size());
+        if (source < 0 || source >= nodeCount || destination < 0 || destination >= nodeCount) {
+            throw std::runtime_error("GraphBuilder: node index out of range");
+        }
+        AbstractNode* sourceNode = graph.nodes[source];
+        AbstractNode* destinationNode = graph.nodes[destination];
+        if (sourceNode->outputFrameTypeId != destinationNode->inputFrameTypeId) {
+            throw std::runtime_error("GraphBuilder: frame types of " + sourceNode->name + " -> " + destinationNode->name + " differ");
+        }
+    }
+
+    Graph& graph;
+    std::vector<std::pair<int, int>> edges;
+    std::vector<std::pair<int, int>> feedbackEdges;
+    // (index into edges, its gain) for the weighted ones
+    std::vector<std::pair<size_t, EdgeGain*>> gains;
+};
@@ -0,0 +1,394 @@
+#pragma once
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifdef __unix__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "NodeBase.h"
+#include "Graph.h"
+#include "NodeRegistry.h"
+
+// binary graph file, native endianness, every section 8 byte aligned
+// - header, then: type names, node table (schedule order), level offsets,
+//   inputs as CSR (consumer -> producers, like Graph::inputCsr), feedback inputs as CSR, edge gains,
+//   string pool, state blob
+// - node indices are schedule positions, so loading needs no sort and the arena comes out in schedule order
+struct GraphFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t typeCount;
+    uint32_t nodeCount;
+    uint32_t levelCount;
+    uint32_t edgeCount;
+    uint32_t feedbackCount;
+    uint32_t gainCount;
+    uint32_t reserved;
+    uint64_t typesOffset;
+    uint64_t nodesOffset;
+    uint64_t levelOffsetsOffset;
+    uint64_t inputOffsetsOffset;
+    uint64_t inputsOffset;
+    uint64_t feedbackOffsetsOffset;
+    uint64_t feedbackInputsOffset;
+    uint64_t gainsOffset;
+    uint64_t stringsOffset;
+    uint64_t stateOffset;
+    uint64_t fileSize;
+};
+
+struct GraphFileString {
+    uint32_t offset;
+    uint32_t length;
+};
+
+struct GraphFileNode {
+    uint32_t type;
+    GraphFileString name;
+    uint32_t stateOffset;
+    uint32_t stateSize;
+};
+
+// the gain of a weighted edge, edge indexes the inputs CSR; ascending by edge
+struct GraphFileGain {
+    uint32_t edge;
+    float gain;
+};
+
+inline constexpr char graphFileMagic[8] = { 'A', 'G', 'R', 'A', 'P', 'H', '\0', '\0' };
+inline constexpr uint32_t graphFileVersion = 2;
+
+// read-only view of a whole file: mmap where available, read into memory otherwise
+struct MappedFile {
+    explicit MappedFile(const char* path) {
+#ifdef __unix__
+        int descriptor = open(path, O_RDONLY);
+        if (descriptor < 0) {
+            throw std::runtime_error(std::string("MappedFile: cannot open ") + path);
+        }
+        struct stat status;
+        if (fstat(descriptor, &status) != 0) {
+            close(descriptor);
+            throw std::runtime_error(std::string("MappedFile: cannot stat ") + path);
+        }
+        size = static_cast<size_t>(status.st_size);
+        void* mapped = size == 0 ? nullptr : mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+        close(descriptor);
+        if (mapped == MAP_FAILED) {
+            throw std::runtime_error(std::string("MappedFile: cannot map ") + path);
+        }
+        data = static_cast<const std::byte*>(mapped);
+#else
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            throw std::runtime_error(std::string("MappedFile: cannot open ") + path);
+        }
+        std::vector<char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        fallback.resize(bytes.size());
+        std::memcpy(fallback.data(), bytes.data(), bytes.size());
+        data = fallback.data();
+        size = fallback.size();
+#endif
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() {
+#ifdef __unix__
+        if (data != nullptr) {
+            munmap(const_cast<std::byte*>(data), size);
+        }
+#endif
+    }
+
+    template <typename T>
+    const T* at(uint64_t offset) const {
+        return reinterpret_cast<const T*>(data + offset);
+    }
+
+    const std::byte* data = nullptr;
+    size_t size = 0;
+#ifndef __unix__
+    std::vector<std::byte> fallback;
+#endif
+};
+
+// writes a prepared graph, every node's type must be registered
+// - a weighted edge is saved with its gain's target
+inline void saveGraph(const Graph& graph, const NodeRegistry& registry, const char* path) {
+    std::vector<std::byte> bytes(sizeof(GraphFileHeader));
+    auto section = [&bytes](const void* source, size_t size) {
+        bytes.resize((bytes.size() + 7) & ~size_t(7));
+        uint64_t offset = bytes.size();
+        bytes.resize(offset + size);
+        if (size > 0) {
+            std::memcpy(bytes.data() + offset, source, size);
+        }
+        return offset;
+    };
+
+    std::vector<AbstractNode*> order;
+    std::vector<uint32_t> positionOf(graph.nodes.size());
+    order.reserve(graph.schedule.nodeIndices.size());
+    for (int index : graph.schedule.nodeIndices) {
+        positionOf[index] = static_cast<uint32_t>(order.size());
+        order.emplace_back(graph.nodes[index]);
+    }
+
+    std::string strings;
+    auto addString = [&strings](const std::string& value) {
+        GraphFileString string { static_cast<uint32_t>(strings.size()), static_cast<uint32_t>(value.size()) };
+        strings += value;
+        return string;
+    };
+
+    std::vector<GraphFileString> types;
+    for (auto& entry : registry.entries) {
+        types.emplace_back(addString(entry.typeName));
+    }
+
+    std::vector<GraphFileNode> nodeTable;
+    std::vector<std::byte> state;
+    std::vector<GraphFileGain> gains;
+    // the graph's CSRs renumbered from node indices to schedule positions, edgeGains: the gains of adjacency's edges
+    auto toCsr = [&](const AdjacencyCsr& adjacency, const std::vector<EdgeGain*>& edgeGains,
+        std::vector<uint32_t>& offsets, std::vector<uint32_t>& inputs) {
+        offsets.assign(1, 0);
+        for (int index : graph.schedule.nodeIndices) {
+            for (int e = adjacency.begin(index); e < adjacency.end(index); e++) {
+                if (!edgeGains.empty() && edgeGains[e] != nullptr) {
+                    gains.emplace_back(GraphFileGain { static_cast<uint32_t>(inputs.size()), edgeGains[e]->get() });
+                }
+                inputs.emplace_back(positionOf[adjacency.inputs[e]]);
+            }
+            offsets.emplace_back(static_cast<uint32_t>(inputs.size()));
+        }
+    };
+    for (auto node : order) {
+        int type = registry.indexOf(node);
+        const NodeRegistry::Entry& entry = registry.entries[type];
+        nodeTable.emplace_back(GraphFileNode {
+            static_cast<uint32_t>(type), addString(node->name),
+            static_cast<uint32_t>(state.size()), static_cast<uint32_t>(entry.stateSize)
+        });
+        state.resize(state.size() + entry.stateSize);
+        entry.saveState(node, state.data() + nodeTable.back().stateOffset);
+    }
+    std::vector<uint32_t> inputOffsets, inputs, feedbackOffsets, feedbackInputs;
+    toCsr(graph.inputCsr, graph.inputCsrGains, inputOffsets, inputs);
+    toCsr(graph.feedbackCsr, {}, feedbackOffsets, feedbackInputs);
+    std::vector<uint32_t> levelOffsets(graph.schedule.levelOffsets.begin(), graph.schedule.levelOffsets.end());
+
+    GraphFileHeader header {};
+    std::memcpy(header.magic, graphFileMagic, sizeof(header.magic));
+    header.version = graphFileVersion;
+    header.typeCount = static_cast<uint32_t>(types.size());
+    header.nodeCount = static_cast<uint32_t>(order.size());
+    header.levelCount = static_cast<uint32_t>(graph.schedule.levelCount());
+    header.edgeCount = static_cast<uint32_t>(inputs.size());
+    header.feedbackCount = static_cast<uint32_t>(feedbackInputs.size());
+    header.gainCount = static_cast<uint32_t>(gains.size());
+    header.typesOffset = section(types.data(), types.size() * sizeof(GraphFileString));
+    header.nodesOffset = section(nodeTable.data(), nodeTable.size() * sizeof(GraphFileNode));
+    header.levelOffsetsOffset = section(levelOffsets.data(), levelOffsets.size() * sizeof(uint32_t));
+    header.inputOffsetsOffset = section(inputOffsets.data(), inputOffsets.size() * sizeof(uint32_t));
+    header.inputsOffset = section(inputs.data(), inputs.size() * sizeof(uint32_t));
+    header.feedbackOffsetsOffset = section(feedbackOffsets.data(), feedbackOffsets.size() * sizeof(uint32_t));
+    header.feedbackInputsOffset = section(feedbackInputs.data(), feedbackInputs.size() * sizeof(uint32_t));
+    header.gainsOffset = section(gains.data(), gains.size() * sizeof(GraphFileGain));
+    header.stringsOffset = section(strings.data(), strings.size());
+    header.stateOffset = section(state.data(), state.size());
+    header.fileSize = bytes.size();
+    std::memcpy(bytes.data(), &header, sizeof(header));
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    if (!file) {
+        throw std::runtime_error(std::string("saveGraph: cannot write ") + path);
+    }
+}
+
+// builds an empty graph from a file written by saveGraph, straight into a compiled plan
+// - nodes are created with Graph::emplace in schedule order, the saved schedule is used as is, no prepare()
+// - the file's CSRs become Graph::inputCsr / feedbackCsr as they are, like a GraphBuilder graph the adjacency maps stay empty
+// - only the compiled plan is set up, type map / instance map stay empty
+// - every saved gain becomes an EdgeGain of the graph, Graph::edgeGain() finds it
+// - call prepareBlock() before running blocks, as after compile()
+// - nothing in the file is trusted: every section, index, offset and length is checked before it is read,
+//   inputs must sit in an earlier level than their consumer; throws before the first node is created
+inline void loadGraph(Graph& graph, const NodeRegistry& registry, const char* path) {
+    if (!graph.nodes.empty()) {
+        throw std::runtime_error("loadGraph: graph is not empty");
+    }
+    MappedFile file(path);
+    if (file.size < sizeof(GraphFileHeader)) {
+        throw std::runtime_error(std::string("loadGraph: truncated file ") + path);
+    }
+    GraphFileHeader header;
+    std::memcpy(&header, file.data, sizeof(header));
+    if (std::memcmp(header.magic, graphFileMagic, sizeof(header.magic)) != 0
+        || header.version != graphFileVersion || header.fileSize != file.size) {
+        throw std::runtime_error(std::string("loadGraph: not a graph file ") + path);
+    }
+    auto require = [path](bool valid, const char* what) {
+        if (!valid) {
+            throw std::runtime_error(std::string("loadGraph: corrupt file ") + path + ": " + what);
+        }
+    };
+
+    // count elements of elementSize at offset, 8 byte aligned and inside the file
+    auto checkSection = [&](uint64_t offset, uint64_t count, uint64_t elementSize, const char* what) {
+        require(offset % 8 == 0 && offset >= sizeof(GraphFileHeader) && offset <= header.fileSize
+            && count * elementSize <= header.fileSize - offset, what);
+    };
+    uint32_t nodeCount = header.nodeCount;
+    checkSection(header.typesOffset, header.typeCount, sizeof(GraphFileString), "type table out of bounds");
+    checkSection(header.nodesOffset, nodeCount, sizeof(GraphFileNode), "node table out of bounds");
+    checkSection(header.levelOffsetsOffset, uint64_t(header.levelCount) + 1, sizeof(uint32_t), "level offsets out of bounds");
+    checkSection(header.inputOffsetsOffset, uint64_t(nodeCount) + 1, sizeof(uint32_t), "input offsets out of bounds");
+    checkSection(header.inputsOffset, header.edgeCount, sizeof(uint32_t), "inputs out of bounds");
+    checkSection(header.feedbackOffsetsOffset, uint64_t(nodeCount) + 1, sizeof(uint32_t), "feedback offsets out of bounds");
+    checkSection(header.feedbackInputsOffset, header.feedbackCount, sizeof(uint32_t), "feedback inputs out of bounds");
+    checkSection(header.gainsOffset, header.gainCount, sizeof(GraphFileGain), "gains out of bounds");
+    // the string pool runs up to the state blob, the state blob up to the end of the file
+    checkSection(header.stringsOffset, 0, 1, "string pool out of bounds");
+    checkSection(header.stateOffset, 0, 1, "state out of bounds");
+    require(header.stringsOffset <= header.stateOffset, "string pool out of bounds");
+    uint64_t stringsSize = header.stateOffset - header.stringsOffset;
+    uint64_t stateSize = header.fileSize - header.stateOffset;
+    auto checkString = [&](const GraphFileString& string) {
+        require(string.offset <= stringsSize && string.length <= stringsSize - string.offset, "string out of bounds");
+    };
+
+    const char* strings = file.at<char>(header.stringsOffset);
+    auto types = file.at<GraphFileString>(header.typesOffset);
+    std::vector<const NodeRegistry::Entry*> entries(header.typeCount);
+    for (uint32_t type = 0; type < header.typeCount; type++) {
+        checkString(types[type]);
+        entries[type] = &registry.find(std::string(strings + types[type].offset, types[type].length));
+    }
+
+    auto nodeTable = file.at<GraphFileNode>(header.nodesOffset);
+    for (uint32_t i = 0; i < nodeCount; i++) {
+        const GraphFileNode& node = nodeTable[i];
+        require(node.type < header.typeCount, "node type out of range");
+        checkString(node.name);
+        require(node.stateOffset <= stateSize && node.stateSize <= stateSize - node.stateOffset, "node state out of bounds");
+        if (entries[node.type]->stateSize != node.stateSize) {
+            throw std::runtime_error("loadGraph: state size of " + entries[node.type]->typeName + " changed");
+        }
+    }
+
+    // levels cover every node once, in order
+    auto levelOffsets = file.at<uint32_t>(header.levelOffsetsOffset);
+    require(levelOffsets[0] == 0 && levelOffsets[header.levelCount] == nodeCount, "level offsets don't cover the nodes");
+    for (uint32_t level = 0; level < header.levelCount; level++) {
+        require(levelOffsets[level] <= levelOffsets[level + 1], "level offsets not ascending");
+    }
+    std::vector<uint32_t> levelOf(nodeCount);
+    for (uint32_t level = 0; level < header.levelCount; level++) {
+        for (uint32_t i = levelOffsets[level]; i < levelOffsets[level + 1]; i++) {
+            levelOf[i] = level;
+        }
+    }
+
+    // CSR offsets ascending up to edgeCount, every input a node of an earlier level
+    // - feedback inputs may come from any level
+    auto checkCsr = [&](const uint32_t* offsets, const uint32_t* inputs, uint32_t edgeCount, bool feedback) {
+        require(offsets[0] == 0 && offsets[nodeCount] == edgeCount, "adjacency offsets don't cover the edges");
+        for (uint32_t consumer = 0; consumer < nodeCount; consumer++) {
+            require(offsets[consumer] <= offsets[consumer + 1], "adjacency offsets not ascending");
+        }
+        for (uint32_t consumer = 0; consumer < nodeCount; consumer++) {
+            for (uint32_t edge = offsets[consumer]; edge < offsets[consumer + 1]; edge++) {
+                require(inputs[edge] < nodeCount, "edge endpoint out of range");
+                require(feedback || levelOf[inputs[edge]] < levelOf[consumer], "input not in an earlier level");
+            }
+        }
+    };
+    checkCsr(file.at<uint32_t>(header.inputOffsetsOffset), file.at<uint32_t>(header.inputsOffset), header.edgeCount, false);
+    checkCsr(file.at<uint32_t>(header.feedbackOffsetsOffset), file.at<uint32_t>(header.feedbackInputsOffset),
+        header.feedbackCount, true);
+
+    // frame types match along every edge, checked on the registry entries so nothing is created yet
+    auto nodeName = [&](uint32_t i) {
+        return std::string(strings + nodeTable[i].name.offset, nodeTable[i].name.length);
+    };
+    auto checkFrameTypes = [&](const uint32_t* offsets, const uint32_t* inputs) {
+        for (uint32_t consumer = 0; consumer < nodeCount; consumer++) {
+            int inputFrameTypeId = entries[nodeTable[consumer].type]->inputFrameTypeId;
+            for (uint32_t edge = offsets[consumer]; edge < offsets[consumer + 1]; edge++) {
+                if (entries[nodeTable[inputs[edge]].type]->outputFrameTypeId != inputFrameTypeId) {
+                    throw std::runtime_error("loadGraph: frame types of " + nodeName(inputs[edge]) + " -> " + nodeName(consumer) + " differ");
+                }
+            }
+        }
+    };
+    checkFrameTypes(file.at<uint32_t>(header.inputOffsetsOffset), file.at<uint32_t>(header.inputsOffset));
+    checkFrameTypes(file.at<uint32_t>(header.feedbackOffsetsOffset), file.at<uint32_t>(header.feedbackInputsOffset));
+
+    // gains on distinct input edges, ascending, finite
+    // - only nodes reading a ScalableFrame have a weighted step
+    auto gains = file.at<GraphFileGain>(header.gainsOffset);
+    auto inputOffsets = file.at<uint32_t>(header.inputOffsetsOffset);
+    uint32_t consumer = 0;
+    for (uint32_t i = 0; i < header.gainCount; i++) {
+        require(gains[i].edge < header.edgeCount && (i == 0 || gains[i - 1].edge < gains[i].edge), "gain edge out of range");
+        require(std::isfinite(gains[i].gain), "gain not finite");
+        while (inputOffsets[consumer + 1] <= gains[i].edge) {
+            consumer++;
+        }
+        if (!entries[nodeTable[consumer].type]->scalableInput) {
+            throw std::runtime_error("loadGraph: input frame of " + nodeName(consumer) + " can't be scaled");
+        }
+    }
+
+    const std::byte* state = file.at<std::byte>(header.stateOffset);
+    graph.nodes.reserve(nodeCount);
+    for (uint32_t i = 0; i < nodeCount; i++) {
+        const GraphFileNode& node = nodeTable[i];
+        const NodeRegistry::Entry& entry = *entries[node.type];
+        std::string name(strings + node.name.offset, node.name.length);
+        AbstractNode* created = entry.create(graph, name.c_str());
+        entry.loadState(created, state + node.stateOffset);
+    }
+
+    auto fromCsr = [nodeCount](const uint32_t* offsets, const uint32_t* inputs, AdjacencyCsr& adjacency) {
+        adjacency.offsets.assign(offsets, offsets + nodeCount + 1);
+        adjacency.inputs.assign(inputs, inputs + offsets[nodeCount]);
+    };
+    fromCsr(file.at<uint32_t>(header.inputOffsetsOffset), file.at<uint32_t>(header.inputsOffset), graph.inputCsr);
+    fromCsr(file.at<uint32_t>(header.feedbackOffsetsOffset), file.at<uint32_t>(header.feedbackInputsOffset),
+        graph.feedbackCsr);
+    if (header.gainCount > 0) {
+        graph.inputCsrGains.assign(header.edgeCount, nullptr);
+        for (uint32_t i = 0; i < header.gainCount; i++) {
+            graph.edgeGains.emplace_back(std::make_unique<EdgeGain>(gains[i].gain));
+            graph.inputCsrGains[gains[i].edge] = graph.edgeGains.back().get();
+        }
+    }
+    graph.adjacencyFromCsr = true;
+    graph.nodeIndex.reserve(nodeCount);
+    for (uint32_t i = 0; i < nodeCount; i++) {
+        graph.nodeIndex[graph.nodes[i]] = static_cast<int>(i);
+    }
+
+    graph.schedule.levelOffsets.assign(levelOffsets, levelOffsets + header.levelCount + 1);
+    graph.schedule.nodeIndices.resize(nodeCount);
+    for (uint32_t i = 0; i < nodeCount; i++) {
+        graph.schedule.nodeIndices[i] = static_cast<int>(i);
+    }
+    graph.compile();
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+#include "FrameBase.h"
+#include "NodeBase.h"
+#include "CustomTypes.h"
+#include "Graph.h"
+
+// parametric layered DAG
+// - SourceNode -> UpcastNode -> `depth` layers of `width` WorkNodes -> DecayNode mixing the last layer
+// - a layer 1+ node takes `fanIn` distinct inputs from the `maxSkip` layers above it,
+//   preferring providers that have fewer than `fanOut` consumers so far
+// - fanIn 1 / fanOut 1 / maxSkip 1 gives `width` parallel chains, maxSkip > 1 adds skip connections
+struct DagShape {
+    const char* name;
+    int width;
+    int depth;
+    int fanIn;
+    int fanOut;
+    int maxSkip;
+    int work;
+    unsigned seed = 1;
+};
+
+struct GeneratedDag {
+    int nodeCount = 0;
+    int edgeCount = 0;
+    // the DecayNode sink's index in Graph::nodes
+    // - an index, not a pointer: prepare() relocates the nodes but keeps their indices
+    int mixerIndex = -1;
+};
+
+// builds into `graph` with Graph::emplace / connect, no context needed
+// - throws on a non-positive width, depth, fanIn or maxSkip
+inline GeneratedDag generateDag(Graph& graph, const DagShape& shape) {
+    if (shape.width < 1 || shape.depth < 1 || shape.fanIn < 1 || shape.maxSkip < 1) {
+        throw std::runtime_error("generateDag: width, depth, fanIn and maxSkip must be positive");
+    }
+    std::mt19937 random(shape.seed);
+    GeneratedDag generated;
+
+    auto& source = graph.emplace<SourceNode>("source");
+    auto& upcast = graph.emplace<UpcastNode>("upcast");
+    graph.connect(source, upcast);
+    generated.edgeCount++;
+
+    std::vector<std::vector<WorkNode*>> layers(shape.depth);
+    std::unordered_map<WorkNode*, int> consumerCount;
+
+    for (int layer = 0; layer < shape.depth; layer++) {
+        for (int i = 0; i < shape.width; i++) {
+            auto& node = graph.emplace<WorkNode>("work");
+            node.work = shape.work;
+
+            if (layer == 0) {
+                graph.connect(upcast, node);
+                generated.edgeCount++;
+            } else {
+                std::vector<WorkNode*> candidates;
+                for (int above = std::max(0, layer - shape.maxSkip); above < layer; above++) {
+                    candidates.insert(candidates.end(), layers[above].begin(), layers[above].end());
+                }
+                std::shuffle(candidates.begin(), candidates.end(), random);
+                std::stable_partition(candidates.begin(), candidates.end(), [&](WorkNode* candidate) {
+                    return consumerCount[candidate] < shape.fanOut;
+                });
+                int inputCount = std::min(shape.fanIn, static_cast<int>(candidates.size()));
+                for (int input = 0; input < inputCount; input++) {
+                    graph.connect(*candidates[input], node);
+                    consumerCount[candidates[input]]++;
+                    generated.edgeCount++;
+                }
+            }
+            layers[layer].emplace_back(&node);
+        }
+    }
+
+    auto& mixer = graph.emplace<DecayNode>("mixer");
+    for (auto node : layers.back()) {
+        graph.connect(*node, mixer);
+        generated.edgeCount++;
+    }
+
+    generated.mixerIndex = static_cast<int>(graph.nodes.size()) - 1;
+    generated.nodeCount = static_cast<int>(graph.nodes.size());
+    return generated;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "FrameBase.h"
+#include "NodeBase.h"
+#include "Graph.h"
+
+
+// wires into the calling thread's Graph::context, see Graph::connect()
+template <Frame X, Frame Y, Frame Z>
+Node<Y,Z> &operator>>(Node<X,Y> &sourceNode, Node<Y,Z> &destinationNode) {
+    Graph::context->connect(sourceNode, destinationNode);
+    return destinationNode;
+}
+
+// feedback edge, see Graph::connectFeedback()
+template <Frame X, Frame Y, Frame Z>
+Node<Y,Z> &operator>>=(Node<X,Y> &sourceNode, Node<Y,Z> &destinationNode) {
+    Graph::context->connectFeedback(sourceNode, destinationNode);
+    return destinationNode;
+}
+
+// a provider with an edge gain, only lives inside `sourceNode * gain >> destinationNode`
+template <Frame X, ScalableFrame Y>
+struct WeightedOutput {
+    Node<X,Y>& node;
+    float gain;
+};
+
+template <Frame X, ScalableFrame Y>
+WeightedOutput<X,Y> operator*(Node<X,Y> &sourceNode, float gain) {
+    return { sourceNode, gain };
+}
+
+// weighted edge, see Graph::connect(sourceNode, destinationNode, gain)
+template <Frame X, ScalableFrame Y, Frame Z>
+Node<Y,Z> &operator>>(WeightedOutput<X,Y> source, Node<Y,Z> &destinationNode) {
+    Graph::context->connect(source.node, destinationNode, source.gain);
+    return destinationNode;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+
+#include "FrameBase.h"
+
+
+// one value per voice of a polyphonic subgraph, lane i belongs to voice i
+// - fixed trip count and vector-width alignment so lane-wise loops vectorize
+template <typename T, int N>
+requires std::is_arithmetic_v<T> && (N > 0)
+struct LaneFrame : public FrameBase {
+    static constexpr int lanes = N;
+
+    LaneFrame() {
+        reset();
+    }
+
+    alignas(sizeof(T) * N >= 32 ? 32 : alignof(T)) T data[N];
+
+    LaneFrame& operator+=(const LaneFrame &other) {
+        for (int i = 0; i < N; i++) {
+            data[i] += other.data[i];
+        }
+        return *(this);
+    }
+    LaneFrame operator+(const LaneFrame &other) const {
+        LaneFrame f = *(this);
+        f += other;
+        return f;
+    }
+    LaneFrame& operator*=(float gain) {
+        for (int i = 0; i < N; i++) {
+            data[i] *= gain;
+        }
+        return *(this);
+    }
+    LaneFrame operator*(float gain) const {
+        LaneFrame f = *(this);
+        f *= gain;
+        return f;
+    }
+    LaneFrame& addScaled(const LaneFrame &input, float gain) {
+        for (int i = 0; i < N; i++) {
+            data[i] += gain * input.data[i];
+        }
+        return *(this);
+    }
+    LaneFrame clone() {
+        return *(this);
+    }
+    void reset() {
+        for (int i = 0; i < N; i++) {
+            data[i] = T{};
+        }
+    }
+};
+
+static_assert(Frame<LaneFrame<float, 8>>);
+static_assert(ScalableFrame<LaneFrame<float, 8>>);
+
+// which lanes of a polyphonic subgraph hold a sounding voice
+// - bits for allocation, gate (1 or 0 per lane) for branchless masking inside tick
+template <int N>
+requires (N > 0 && N <= 32)
+struct LaneMask {
+    uint32_t bits = 0;
+    alignas(sizeof(float) * N >= 32 ? 32 : alignof(float)) float gate[N] = {};
+
+    bool active(int lane) const {
+        return (bits >> lane) & 1u;
+    }
+    bool full() const {
+        return bits == (N == 32 ? ~0u : (1u << N) - 1u);
+    }
+    void set(int lane, bool active) {
+        if (active) {
+            bits |= 1u << lane;
+        } else {
+            bits &= ~(1u << lane);
+        }
+        gate[lane] = active ? 1.f : 0.f;
+    }
+};
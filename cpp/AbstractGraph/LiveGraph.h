@@ -0,0 +1,196 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "FrameBase.h"
+#include "NodeBase.h"
+#include "Graph.h"
+
+// a graph that can be edited while it is processing
+// - control thread: add/remove nodes and edges on a shadow Graph, then publish()
+//   publish() sorts and compiles a fresh ExecutionPlan off the audio thread and swaps it in
+// - audio thread: processBlock() picks up whatever plan is published at the block boundary,
+//   one atomic load and one atomic store per block, no locks, no allocation, never frees anything
+// - reclamation: a replaced plan is freed by the control thread once the audio thread has
+//   finished a block that started after the swap; nodes removed from the graph live until then
+//   because every published plan holds a reference to its nodes
+struct LiveGraph {
+    explicit LiveGraph(int maxBlockSize) : maxBlockSize(maxBlockSize) { }
+    LiveGraph(const LiveGraph&) = delete;
+    LiveGraph& operator=(const LiveGraph&) = delete;
+
+    ~LiveGraph() {
+        delete published.load();
+        for (auto& retired : retiredPlans) {
+            delete retired.plan;
+        }
+    }
+
+    // ----------------
+    // Control thread
+
+    template <typename NodeT>
+    NodeT& addNode(const char* name) {
+        auto node = std::make_shared<NodeT>(name);
+        node->prepareBlock(maxBlockSize);
+        shadow.nodes.emplace_back(node.get());
+        shadow.bind(node.get());
+        ownedNodes[node.get()] = node;
+        return *node;
+    }
+
+    void removeNode(AbstractNode* node) {
+        std::erase(shadow.nodes, node);
+        shadow.nodeAdjacencyMap.erase(node);
+        shadow.inputGains.erase(node);
+        shadow.feedbackAdjacencyMap.erase(node);
+        for (auto& [consumer, inputs] : shadow.nodeAdjacencyMap) {
+            for (size_t i = inputs.size(); i-- > 0;) {
+                if (inputs[i] == node) {
+                    eraseInput(consumer, inputs, i);
+                }
+            }
+        }
+        for (auto& [consumer, inputs] : shadow.feedbackAdjacencyMap) {
+            std::erase(inputs, node);
+        }
+        shadow.bindings.erase(node);
+        ownedNodes.erase(node);
+    }
+
+    template <Frame X, Frame Y, Frame Z>
+    void connect(Node<X,Y>& sourceNode, Node<Y,Z>& destinationNode) {
+        shadow.nodeAdjacencyMap[&destinationNode].emplace_back(&sourceNode);
+    }
+
+    // weighted edge, see Graph::connect(source, destination, gain)
+    // - the gain lives as long as the LiveGraph, so plans still running keep a valid pointer after a disconnect
+    template <Frame X, ScalableFrame Y, Frame Z>
+    EdgeGain& connect(Node<X,Y>& sourceNode, Node<Y,Z>& destinationNode, float gain) {
+        std::vector<AbstractNode*>& inputs = shadow.nodeAdjacencyMap[&destinationNode];
+        inputs.emplace_back(&sourceNode);
+        shadow.edgeGains.emplace_back(std::make_unique<EdgeGain>(gain));
+        std::vector<EdgeGain*>& gains = shadow.inputGains[&destinationNode];
+        gains.resize(inputs.size(), nullptr);
+        gains.back() = shadow.edgeGains.back().get();
+        return *shadow.edgeGains.back();
+    }
+
+    template <Frame X, Frame Y, Frame Z>
+    void connectFeedback(Node<X,Y>& sourceNode, Node<Y,Z>& destinationNode) {
+        shadow.feedbackAdjacencyMap[&destinationNode].emplace_back(&sourceNode);
+    }
+
+    // removes one edge, a no-op when the edge does not exist
+    template <Frame X, Frame Y, Frame Z>
+    void disconnect(Node<X,Y>& sourceNode, Node<Y,Z>& destinationNode) {
+        auto inputs = shadow.nodeAdjacencyMap.find(&destinationNode);
+        if (inputs == shadow.nodeAdjacencyMap.end()) {
+            return;
+        }
+        auto edge = std::find(inputs->second.begin(), inputs->second.end(), &sourceNode);
+        if (edge != inputs->second.end()) {
+            eraseInput(&destinationNode, inputs->second, edge - inputs->second.begin());
+        }
+    }
+
+    // removes one feedback edge, a no-op when the edge does not exist
+    template <Frame X, Frame Y, Frame Z>
+    void disconnectFeedback(Node<X,Y>& sourceNode, Node<Y,Z>& destinationNode) {
+        auto inputs = shadow.feedbackAdjacencyMap.find(&destinationNode);
+        if (inputs == shadow.feedbackAdjacencyMap.end()) {
+            return;
+        }
+        auto edge = std::find(inputs->second.begin(), inputs->second.end(), &sourceNode);
+        if (edge != inputs->second.end()) {
+            inputs->second.erase(edge);
+        }
+    }
+
+    // builds the next plan from the shadow graph and swaps it in
+    // - throws (and keeps the current plan) when the edits made the graph cyclic
+    void publish() {
+        shadow.prepare();
+        shadow.compile();
+
+        auto next = new PublishedPlan { shadow.plan, {} };
+        next->nodes.reserve(ownedNodes.size());
+        for (auto& [node, owned] : ownedNodes) {
+            next->nodes.emplace_back(owned);
+        }
+
+        PublishedPlan* previous = published.exchange(next, std::memory_order_seq_cst);
+        if (previous != nullptr) {
+            retiredPlans.emplace_back(RetiredPlan { previous, blocksDone.load(std::memory_order_seq_cst) });
+        }
+        planCount++;
+        reclaim();
+    }
+
+    // frees every replaced plan the audio thread can no longer be reading, returns how many are still pending
+    int reclaim() {
+        uint64_t done = blocksDone.load(std::memory_order_seq_cst);
+        std::erase_if(retiredPlans, [done](const RetiredPlan& retired) {
+            if (done > retired.blocksDoneAtRetire) {
+                delete retired.plan;
+                return true;
+            }
+            return false;
+        });
+        return static_cast<int>(retiredPlans.size());
+    }
+
+    int publishedPlanCount() const {
+        return planCount;
+    }
+
+    // ----------------
+    // Audio thread
+
+    // count must not exceed maxBlockSize
+    void processBlock(int count) {
+        PublishedPlan* current = published.load(std::memory_order_seq_cst);
+        if (current != nullptr) {
+            current->plan.runBlock(count);
+        }
+        blocksDone.store(blocksDone.load(std::memory_order_relaxed) + 1, std::memory_order_seq_cst);
+    }
+
+private:
+    // removes inputs[index] of consumer together with its gain, if it has one
+    void eraseInput(AbstractNode* consumer, std::vector<AbstractNode*>& inputs, size_t index) {
+        auto gains = shadow.inputGains.find(consumer);
+        if (gains != shadow.inputGains.end() && index < gains->second.size()) {
+            gains->second.erase(gains->second.begin() + index);
+        }
+        inputs.erase(inputs.begin() + index);
+    }
+
+    struct PublishedPlan {
+        ExecutionPlan plan;
+        std::vector<std::shared_ptr<AbstractNode>> nodes;
+    };
+
+    // the audio thread may still be inside `plan` until blocksDone moves past blocksDoneAtRetire
+    struct RetiredPlan {
+        PublishedPlan* plan;
+        uint64_t blocksDoneAtRetire;
+    };
+
+    int maxBlockSize;
+
+    // control thread only
+    Graph shadow;
+    std::map<AbstractNode*, std::shared_ptr<AbstractNode>> ownedNodes;
+    std::vector<RetiredPlan> retiredPlans;
+    int planCount = 0;
+
+    // shared with the audio thread
+    std::atomic<PublishedPlan*> published = nullptr;
+    std::atomic<uint64_t> blocksDone = 0;
+};
@@ -0,0 +1,149 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "NodeBase.h"
+
+// owns nodes created through Graph::emplace
+// - nodes are first bump-allocated in chunks, in creation order
+// - layout(order) moves every owned node into one contiguous buffer in the given order,
+//   so node state and lastOutput of consecutive steps sit next to each other
+struct NodeArena {
+    NodeArena() = default;
+    NodeArena(const NodeArena&) = delete;
+    NodeArena& operator=(const NodeArena&) = delete;
+
+    ~NodeArena() {
+        for (auto& entry : entries) {
+            entry.destroy(entry.node);
+        }
+    }
+
+    template <typename NodeT, typename... Args>
+    NodeT* emplace(Args&&... args) {
+        void* memory = allocate(sizeof(NodeT), alignof(NodeT));
+        NodeT* node = new (memory) NodeT(std::forward<Args>(args)...);
+        entries.emplace_back(Entry {
+            node,
+            sizeof(NodeT),
+            alignof(NodeT),
+            [](void* destination, AbstractNode* source) -> AbstractNode* {
+                NodeT* typedSource = static_cast<NodeT*>(source);
+                NodeT* moved = new (destination) NodeT(std::move(*typedSource));
+                typedSource->~NodeT();
+                return moved;
+            },
+            [](AbstractNode* node) {
+                static_cast<NodeT*>(node)->~NodeT();
+            }
+        });
+        return node;
+    }
+
+    bool empty() const {
+        return entries.empty();
+    }
+
+    // owned nodes in `order` come first, in that order, any others follow in creation order
+    // returns old address -> new address for every owned node
+    std::unordered_map<AbstractNode*, AbstractNode*> layout(const std::vector<AbstractNode*>& order) {
+        std::unordered_map<AbstractNode*, size_t> entryOf;
+        entryOf.reserve(entries.size());
+        for (size_t i = 0; i < entries.size(); i++) {
+            entryOf[entries[i].node] = i;
+        }
+
+        std::vector<size_t> placement;
+        std::vector<bool> placed(entries.size(), false);
+        placement.reserve(entries.size());
+        for (auto node : order) {
+            auto entry = entryOf.find(node);
+            if (entry != entryOf.end() && !placed[entry->second]) {
+                placed[entry->second] = true;
+                placement.emplace_back(entry->second);
+            }
+        }
+        for (size_t i = 0; i < entries.size(); i++) {
+            if (!placed[i]) {
+                placement.emplace_back(i);
+            }
+        }
+
+        size_t bytes = 0;
+        std::vector<size_t> offsets;
+        offsets.reserve(placement.size());
+        for (size_t i : placement) {
+            bytes = alignUp(bytes, entries[i].alignment);
+            offsets.emplace_back(bytes);
+            bytes += entries[i].size;
+        }
+
+        Chunk buffer = makeChunk(bytes);
+        std::unordered_map<AbstractNode*, AbstractNode*> relocated;
+        relocated.reserve(entries.size());
+        std::vector<Entry> laidOut;
+        laidOut.reserve(entries.size());
+        for (size_t k = 0; k < placement.size(); k++) {
+            Entry entry = entries[placement[k]];
+            AbstractNode* moved = entry.relocate(buffer.get() + offsets[k], entry.node);
+            relocated[entry.node] = moved;
+            entry.node = moved;
+            laidOut.emplace_back(entry);
+        }
+
+        entries = std::move(laidOut);
+        chunks.clear();
+        chunks.emplace_back(std::move(buffer));
+        chunkUsed = bytes;
+        chunkCapacity = bytes;
+        return relocated;
+    }
+
+private:
+    struct Entry {
+        AbstractNode* node;
+        size_t size;
+        size_t alignment;
+        AbstractNode* (*relocate)(void* destination, AbstractNode* source);
+        void (*destroy)(AbstractNode* node);
+    };
+
+    struct ChunkDelete {
+        void operator()(std::byte* memory) const {
+            ::operator delete[](memory, std::align_val_t(chunkAlignment));
+        }
+    };
+    using Chunk = std::unique_ptr<std::byte[], ChunkDelete>;
+
+    static constexpr size_t chunkAlignment = 64;
+    static constexpr size_t chunkSize = 1 << 16;
+
+    static size_t alignUp(size_t value, size_t alignment) {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    static Chunk makeChunk(size_t bytes) {
+        return Chunk(static_cast<std::byte*>(::operator new[](std::max<size_t>(bytes, 1), std::align_val_t(chunkAlignment))));
+    }
+
+    void* allocate(size_t size, size_t alignment) {
+        size_t offset = alignUp(chunkUsed, alignment);
+        if (chunks.empty() || offset + size > chunkCapacity) {
+            chunkCapacity = std::max(chunkSize, size);
+            chunks.emplace_back(makeChunk(chunkCapacity));
+            offset = 0;
+        }
+        chunkUsed = offset + size;
+        return chunks.back().get() + offset;
+    }
+
+    std::vector<Entry> entries;
+    std::vector<Chunk> chunks;
+    size_t chunkUsed = 0;
+    size_t chunkCapacity = 0;
+};
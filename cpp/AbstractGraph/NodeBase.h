@@ -1,17 +1,60 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
 #include <string>
 #include <typeindex>
+#include <utility>
+#include <vector>
 
 #include "FrameBase.h"
 
 
+// how an output depends on time, read by Graph::compile() when folding constants
+// - stateful: the default, ticked every sample
+// - pure:     output depends only on the current input
+// - constant: output never changes, whatever the input
+enum class NodePurity { stateful, pure, constant };
+
+// how often a node ticks, read by Graph::compile()
+// - divisor 1: every sample, the default
+// - divisor N: every N samples; in between the output holds the last value,
+//   or with interpolate ramps linearly from the previous value to it (InterpolableFrame outputs only)
+struct NodeRate {
+    int divisor = 1;
+    bool interpolate = false;
+};
+
 struct AbstractNode {
     std::string name;
-    AbstractNode(const char *name) : name(std::string(name)) { }
+    int inputFrameTypeId;
+    int outputFrameTypeId;
+    AbstractNode(const char *name, int inputFrameTypeId, int outputFrameTypeId)
+        : name(std::string(name)), inputFrameTypeId(inputFrameTypeId), outputFrameTypeId(outputFrameTypeId) { }
     virtual std::type_index getTypeIdInput() = 0;
     virtual std::type_index getTypeIdOutput() = 0;
     virtual void reset() = 0;
+    virtual void prepareBlock(int maxBlockSize) = 0;
+    // flips the double-buffered output: count == 0 keeps the last sample, otherwise swaps the block slots
+    virtual void commitOutput(int count) = 0;
+    // repeats lastOutput over both block slots and the previous output, for folded nodes
+    virtual void holdOutput() = 0;
+    virtual NodePurity purity() const {
+        return NodePurity::stateful;
+    }
+    virtual NodeRate rate() const {
+        return {};
+    }
+
+    // call after changing a parameter of a constant or pure node, reset() calls it too
+    // - if compile() folded the node, the plan refolds before its next tick/block
+    void markChanged() {
+        if (foldedChanged != nullptr) {
+            foldedChanged->store(true, std::memory_order_release);
+        }
+    }
+    // the plan's ExecutionPlan::constantsChanged, set by Graph::compile() on folded nodes only
+    std::atomic<bool>* foldedChanged = nullptr;
 };
 
 template <Frame InputT>
@@ -22,17 +65,56 @@ struct NodeInput {
 template <Frame OutputT>
 struct NodeOutput {
     virtual OutputT getResult() = 0;
+    virtual const OutputT* getBlock() = 0;
+
+    // zero-copy views, valid until the node processes again
+    virtual const OutputT& viewResult() = 0;
+
+    // previous tick/block, read by feedback edges
+    virtual const OutputT& viewPreviousResult() = 0;
+    virtual const OutputT* getPreviousBlock() = 0;
+
+    // the block slots themselves: they flip on commitOutput(), so readers keep the slot, not the block
+    virtual const OutputT* const* currentBlockSlot() = 0;
+    virtual const OutputT* const* previousBlockSlot() = 0;
+};
+
+// endpoints of a control-rate ramp, only kept for frames that can be interpolated
+template <typename T, bool = InterpolableFrame<T>>
+struct ControlRamp {
+    T from;
+    T to;
+    void reset() {
+        from.reset();
+        to.reset();
+    }
+};
+
+template <typename T>
+struct ControlRamp<T, false> {
+    void reset() {}
 };
 
 template <Frame InputT, Frame OutputT>
 struct Node : public NodeInput<InputT>, public NodeOutput<OutputT>, public AbstractNode {
-    Node(const char *nodeName) : AbstractNode(nodeName), lastOutput({}) { }
+    using InputType = InputT;
+    using OutputType = OutputT;
+
+    Node(const char *nodeName)
+        : AbstractNode(nodeName, frameTypeId<InputT>(), frameTypeId<OutputT>()), lastOutput({}) { }
 
     void processNext(const InputT& input) override {
         lastOutput = tick(input);
     }
 
-    virtual OutputT tick(InputT input) = 0;
+    virtual OutputT tick(const InputT& input) = 0;
+
+    // statically dispatched processNext for a known concrete node type, used by StaticGraph
+    template <typename NodeT>
+    const OutputT& tickAs(const InputT& input) {
+        lastOutput = static_cast<NodeT*>(this)->NodeT::tick(input);
+        return lastOutput;
+    }
 
     OutputT getResult() override {
         return lastOutput.clone();
@@ -46,18 +128,152 @@ struct Node : public NodeInput<InputT>, public NodeOutput<OutputT>, public Abstr
         return typeid(OutputT);
     }
 
+    const OutputT& viewResult() override {
+        return lastOutput;
+    }
+
     void reset() override {
         lastOutput.reset();
+        previousOutput.reset();
+        ramp.reset();
+        controlPhase = 0;
+        for (auto& slot : blockSlots) {
+            for (auto& frame : slot) {
+                frame.reset();
+            }
+        }
+        markChanged();
+    }
+
+    // ----------------
+    // Block processing
+    // - default loops tick, nodes can override with vectorized code
+    // - must leave the last frame of the block in lastOutput
+    virtual void processBlock(const InputT* input, OutputT* output, int count) {
+        for (int i = 0; i < count; i++) {
+            lastOutput = tick(input[i]);
+            output[i] = lastOutput;
+        }
+    }
+
+    void prepareBlock(int maxBlockSize) override {
+        inputBlock.resize(maxBlockSize);
+        for (auto& slot : blockSlots) {
+            slot.assign(maxBlockSize, OutputT());
+        }
+        currentBlock = blockSlots[0].data();
+        previousBlock = blockSlots[1].data();
+    }
+
+    const OutputT* getBlock() override {
+        return currentBlock;
+    }
+
+    InputT* getInputBlock() {
+        return inputBlock.data();
+    }
+
+    void processNextBlock(int count) {
+        processBlock(inputBlock.data(), currentBlock, count);
+    }
+
+    // reads the input block straight from a provider, for single-input nodes
+    void processNextBlock(const InputT* input, int count) {
+        processBlock(input, currentBlock, count);
+    }
+
+    // ----------------
+    // Double-buffered output
+    // consumers can read the previous tick/block while this one is written
+    const OutputT& viewPreviousResult() override {
+        return previousOutput;
+    }
+
+    const OutputT* getPreviousBlock() override {
+        return previousBlock;
+    }
+
+    const OutputT* const* currentBlockSlot() override {
+        return &currentBlock;
+    }
+
+    const OutputT* const* previousBlockSlot() override {
+        return &previousBlock;
+    }
+
+    void commitOutput(int count) override {
+        if (count == 0) {
+            previousOutput = lastOutput;
+        } else {
+            std::swap(currentBlock, previousBlock);
+        }
+    }
+
+    // ----------------
+    // Control rate, see NodeRate
+    // - controlDue(): the compiled step only gathers inputs and ticks on samples where this is true
+    // - advanceControl(): the output of every sample, the new value or a ramp towards it
+    bool controlDue() const {
+        return controlPhase == 0;
+    }
+
+    // tick sees its own last ticked output in lastOutput, not the ramp
+    void tickControl(const InputT& input) {
+        if constexpr (InterpolableFrame<OutputT>) {
+            lastOutput = ramp.to;
+            ramp.from = ramp.to;
+            ramp.to = tick(input);
+        } else {
+            lastOutput = tick(input);
+        }
+    }
+
+    const OutputT& advanceControl(const NodeRate& rate) {
+        controlPhase++;
+        if constexpr (InterpolableFrame<OutputT>) {
+            lastOutput = rate.interpolate
+                ? OutputT::lerp(ramp.from, ramp.to, static_cast<float>(controlPhase) / rate.divisor)
+                : ramp.to;
+        }
+        if (controlPhase == rate.divisor) {
+            controlPhase = 0;
+        }
+        return lastOutput;
+    }
+
+    // block version, inputAt(s) is the summed input of sample s, only called on due samples
+    template <typename InputAt>
+    void processControlBlock(InputAt&& inputAt, int count, const NodeRate& rate) {
+        for (int s = 0; s < count; s++) {
+            if (controlDue()) {
+                tickControl(inputAt(s));
+            }
+            currentBlock[s] = advanceControl(rate);
+        }
+    }
+
+    void holdOutput() override {
+        previousOutput = lastOutput;
+        for (auto& slot : blockSlots) {
+            std::fill(slot.begin(), slot.end(), lastOutput);
+        }
     }
     
     NodeInput<InputT>* asInput() {
-        return dynamic_cast<NodeInput<InputT>*>(this);
+        return this;
     }
 
     NodeOutput<OutputT>* asOutput() {
-        return dynamic_cast<NodeOutput<OutputT>*>(this);
+        return this;
     }
     
 protected: 
     OutputT lastOutput;
+    std::vector<InputT> inputBlock;
+    OutputT previousOutput;
+    std::vector<OutputT> blockSlots[2];
+    OutputT* currentBlock = nullptr;
+    OutputT* previousBlock = nullptr;
+    ControlRamp<OutputT> ramp;
+    int controlPhase = 0;
 };
\ No newline at end of file
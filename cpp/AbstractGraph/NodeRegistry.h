@@ -0,0 +1,78 @@
+#pragma once
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <typeindex>
+#include <unordered_map>
+#include <vector>
+
+#include "NodeBase.h"
+#include "Graph.h"
+
+// node factories keyed by type name, for graphs built from data instead of C++
+// - add<NodeT>(typeName, &NodeT::field...) registers a node type and the fields that make up its initial state
+// - state fields must be trivially copyable, they are stored as raw bytes in declaration order
+// - RTTI is only used on the save side, to find a live node's entry
+// - entries carry the node type's frame type ids, so a loader can check edges before creating any node
+struct NodeRegistry {
+    struct Entry {
+        std::string typeName;
+        AbstractNode* (*create)(Graph& graph, const char* name);
+        size_t stateSize;
+        std::function<void(AbstractNode*, std::byte*)> saveState;
+        std::function<void(AbstractNode*, const std::byte*)> loadState;
+        int inputFrameTypeId;
+        int outputFrameTypeId;
+        // the input frame is a ScalableFrame, so the node can take weighted inputs
+        bool scalableInput;
+    };
+
+    template <typename NodeT, typename... Fields>
+    requires (std::is_trivially_copyable_v<Fields> && ...)
+    void add(const char* typeName, Fields NodeT::*... fields) {
+        Entry entry {
+            typeName,
+            [](Graph& graph, const char* name) -> AbstractNode* {
+                return &graph.emplace<NodeT>(name);
+            },
+            (sizeof(Fields) + ... + 0),
+            [fields...](AbstractNode* node, std::byte* state) {
+                [[maybe_unused]] auto typed = static_cast<NodeT*>(node);
+                ((std::memcpy(state, &(typed->*fields), sizeof(Fields)), state += sizeof(Fields)), ...);
+            },
+            [fields...](AbstractNode* node, const std::byte* state) {
+                [[maybe_unused]] auto typed = static_cast<NodeT*>(node);
+                ((std::memcpy(&(typed->*fields), state, sizeof(Fields)), state += sizeof(Fields)), ...);
+            },
+            frameTypeId<typename NodeT::InputType>(),
+            frameTypeId<typename NodeT::OutputType>(),
+            ScalableFrame<typename NodeT::InputType>
+        };
+        indexOfName[entry.typeName] = static_cast<int>(entries.size());
+        indexOfType.insert_or_assign(std::type_index(typeid(NodeT)), static_cast<int>(entries.size()));
+        entries.emplace_back(std::move(entry));
+    }
+
+    const Entry& find(const std::string& typeName) const {
+        auto index = indexOfName.find(typeName);
+        if (index == indexOfName.end()) {
+            throw std::runtime_error("NodeRegistry: unknown node type " + typeName);
+        }
+        return entries[index->second];
+    }
+
+    int indexOf(AbstractNode* node) const {
+        auto index = indexOfType.find(std::type_index(typeid(*node)));
+        if (index == indexOfType.end()) {
+            throw std::runtime_error("NodeRegistry: node " + node->name + " has an unregistered type");
+        }
+        return index->second;
+    }
+
+    std::vector<Entry> entries;
+    std::unordered_map<std::string, int> indexOfName;
+    std::unordered_map<std::type_index, int> indexOfType;
+};
@@ -0,0 +1,130 @@
+#pragma once
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "../misc/ThreadPool.h"
+#include "Graph.h"
+
+// runs each level of a compiled plan across persistent workers
+// - workers sleep on the pool semaphore between ticks/blocks
+// - one fork/join per parallel level: an epoch broadcast plus an arrival counter
+// - levels narrower than minParallelWidth run inline on the calling thread
+// - every node still runs exactly the same step, so results are bit-identical to the serial plan
+struct ParallelLevelExecutor {
+    ParallelLevelExecutor(const ExecutionPlan& plan, int workerCount, int minParallelWidth)
+        : plan(plan), workerCount(workerCount < 1 ? 1 : workerCount), pool(0) {
+
+        for (int level = 0; level + 1 < static_cast<int>(plan.levelOffsets.size()); level++) {
+            int width = plan.levelOffsets[level + 1] - plan.levelOffsets[level];
+            parallelLevel.emplace_back(this->workerCount > 1 && width >= minParallelWidth);
+            if (parallelLevel.back()) {
+                parallelLevelCount++;
+            }
+        }
+
+        for (int worker = 1; worker < this->workerCount; worker++) {
+            pool.addWorker([this, worker] {
+                // epochs are consumed strictly in order, the caller can't fork again before every worker arrived
+                int seenEpoch = 0;
+                while (true) {
+                    pool.newWorkSemaphore.acquire();
+                    if (pool.done) {
+                        break;
+                    }
+                    for (int i = 0; i < parallelLevelCount; i++) {
+                        seenEpoch = waitForEpoch(seenEpoch);
+                        runShare(activeLevel, worker);
+                        arrived.fetch_add(1, std::memory_order_release);
+                    }
+                }
+            });
+        }
+    }
+
+    // one sample
+    void run() {
+        execute(0);
+    }
+
+    // one block, count must not exceed the size given to Graph::prepareBlock()
+    void runBlock(int count) {
+        execute(count);
+    }
+
+private:
+    void execute(int count) {
+        plan.refreshChangedConstants();
+        blockCount = count;
+        if (parallelLevelCount > 0) {
+            for (int worker = 1; worker < workerCount; worker++) {
+                pool.enqueue();
+            }
+        }
+
+        for (int level = 0; level < static_cast<int>(parallelLevel.size()); level++) {
+            if (!parallelLevel[level]) {
+                runSteps(plan.levelOffsets[level], plan.levelOffsets[level + 1]);
+                continue;
+            }
+
+            // fork
+            activeLevel = level;
+            arrived.store(0, std::memory_order_relaxed);
+            epoch.fetch_add(1, std::memory_order_release);
+
+            runShare(level, 0);
+
+            // join
+            int spins = 0;
+            while (arrived.load(std::memory_order_acquire) < workerCount - 1) {
+                if (++spins > spinLimit) {
+                    std::this_thread::yield();
+                }
+            }
+        }
+        plan.commitFeedback(blockCount);
+    }
+
+    int waitForEpoch(int seenEpoch) {
+        int spins = 0;
+        int current = epoch.load(std::memory_order_acquire);
+        while (current == seenEpoch) {
+            if (++spins > spinLimit) {
+                std::this_thread::yield();
+            }
+            current = epoch.load(std::memory_order_acquire);
+        }
+        return current;
+    }
+
+    // contiguous slice of the level per worker, keeps neighbouring steps on one core
+    void runShare(int level, int worker) {
+        int begin = plan.levelOffsets[level];
+        int width = plan.levelOffsets[level + 1] - begin;
+        runSteps(
+            begin + width * worker / workerCount,
+            begin + width * (worker + 1) / workerCount);
+    }
+
+    void runSteps(int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            plan.runStep(i, blockCount);
+        }
+    }
+
+    static constexpr int spinLimit = 1 << 10;
+
+    const ExecutionPlan& plan;
+    int workerCount;
+    std::vector<bool> parallelLevel;
+    int parallelLevelCount = 0;
+
+    int blockCount = 0;
+    int activeLevel = 0;
+    std::atomic<int> epoch = 0;
+    std::atomic<int> arrived = 0;
+
+    // declared last: joins the workers before anything they touch is destroyed
+    ThreadPool pool;
+};
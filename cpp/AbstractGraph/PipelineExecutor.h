@@ -0,0 +1,213 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "../misc/ThreadPool.h"
+#include "Graph.h"
+
+// pipelined block execution: consecutive levels form stages, stage s works on block n - s while stage 0 takes block n
+// - stages are contiguous level ranges balanced by step cost (e.g. measureStepCosts()), one thread each
+// - an edge from stage a into stage b > a reads the producer's block through a BlockQueue, b - a blocks behind;
+//   the producer pushes its block right after running, one queue per producer sized for its farthest reader
+// - one barrier per block, no other synchronisation: within a stage steps run in plan order
+// - output of block n comes out of runBlock() latencyBlocks() calls later, drain() flushes the blocks in flight
+// - blocks only, no single samples; feedback edges must stay inside one stage, the constructor throws otherwise
+// - works on its own copy of the plan, compile() again means a new executor
+struct PipelineExecutor {
+    PipelineExecutor(Graph& graph, const std::vector<double>& costs, int stageCount, int maxBlockSize)
+        : plan(graph.plan), pool(0) {
+
+        int levelCount = static_cast<int>(plan.levelOffsets.size()) - 1;
+        this->stageCount = std::max(1, std::min(stageCount, levelCount));
+
+        // contiguous levels per stage, cut where the running cost passes the next equal share
+        std::vector<double> levelCosts(levelCount, 0.0);
+        for (int level = 0; level < levelCount; level++) {
+            for (int step = plan.levelOffsets[level]; step < plan.levelOffsets[level + 1]; step++) {
+                levelCosts[level] += costs[step];
+            }
+        }
+        double totalCost = std::accumulate(levelCosts.begin(), levelCosts.end(), 0.0);
+        stageOffsets.assign(1, 0);
+        double runningCost = 0.0;
+        for (int level = 0; level < levelCount; level++) {
+            runningCost += levelCosts[level];
+            int stagesLeft = this->stageCount - static_cast<int>(stageOffsets.size());
+            int levelsLeft = levelCount - level - 1;
+            bool share = runningCost >= totalCost * static_cast<int>(stageOffsets.size()) / this->stageCount;
+            if (stagesLeft > 0 && (share || levelsLeft == stagesLeft) && levelsLeft >= stagesLeft) {
+                stageOffsets.emplace_back(plan.levelOffsets[level + 1]);
+            }
+        }
+        stageOffsets.emplace_back(static_cast<int>(plan.steps.size()));
+
+        // which stage every lowered node runs in, and whose output every block slot is
+        std::unordered_map<AbstractNode*, int> stageOf;
+        std::unordered_map<AbstractNode*, int> stepOf;
+        std::unordered_map<const void*, AbstractNode*> producerOf;
+        for (int stage = 0; stage < this->stageCount; stage++) {
+            for (int step = stageOffsets[stage]; step < stageOffsets[stage + 1]; step++) {
+                const CompiledStep& compiled = plan.steps[step];
+                for (int link = -1; link < compiled.chainEnd - compiled.chainBegin; link++) {
+                    AbstractNode* node = link < 0 ? compiled.node : plan.chainSteps[compiled.chainBegin + link].node;
+                    stageOf[node] = stage;
+                    stepOf[node] = step;
+                    producerOf[graph.bindings.at(node).edge(node, false).block] = node;
+                    producerOf[graph.bindings.at(node).edge(node, true).block] = node;
+                }
+            }
+        }
+
+        // cross-stage edges, folded constants are no producer: their output is held
+        struct CrossEdge {
+            int edge;
+            AbstractNode* producer;
+            int lag;
+        };
+        std::vector<CrossEdge> crossEdges;
+        std::unordered_map<AbstractNode*, int> maxLag;
+        for (int step = 0; step < static_cast<int>(plan.steps.size()); step++) {
+            const CompiledStep& compiled = plan.steps[step];
+            int stage = stageOf.at(compiled.node);
+            for (int edge = compiled.inputBegin; edge < compiled.feedbackEnd; edge++) {
+                auto producer = producerOf.find(plan.edges[edge].block);
+                if (producer == producerOf.end() || stageOf.at(producer->second) == stage) {
+                    continue;
+                }
+                if (edge >= compiled.inputEnd) {
+                    throw std::runtime_error("PipelineExecutor: feedback edge " + producer->second->name
+                        + " -> " + compiled.node->name + " crosses stages");
+                }
+                int lag = stage - stageOf.at(producer->second);
+                crossEdges.emplace_back(CrossEdge { edge, producer->second, lag });
+                maxLag[producer->second] = std::max(maxLag[producer->second], lag);
+            }
+        }
+
+        queueOfStep.resize(plan.steps.size());
+        std::unordered_map<AbstractNode*, AbstractBlockQueue*> queueOf;
+        for (auto& [producer, lag] : maxLag) {
+            queues.emplace_back(graph.bindings.at(producer).blockQueue(producer, lag, maxBlockSize));
+            queueOf[producer] = queues.back().get();
+            queueOfStep[stepOf.at(producer)].emplace_back(queues.back().get());
+        }
+        for (auto& cross : crossEdges) {
+            plan.edges[cross.edge].block = queueOf.at(cross.producer)->readSlot(cross.lag);
+        }
+
+        stageFeedback.resize(this->stageCount);
+        for (auto node : plan.feedbackSources) {
+            stageFeedback[stageOf.at(node)].emplace_back(node);
+        }
+
+        blockCounts.assign(this->stageCount, 0);
+        for (int stage = 1; stage < this->stageCount; stage++) {
+            pool.addWorker([this] {
+                while (true) {
+                    pool.newWorkSemaphore.acquire();
+                    if (pool.done) {
+                        break;
+                    }
+                    runStage(nextStage.fetch_add(1, std::memory_order_relaxed));
+                    finished.fetch_add(1, std::memory_order_release);
+                }
+            });
+        }
+    }
+
+    // takes one new block in, count must not exceed maxBlockSize
+    void runBlock(int count) {
+        tick(count);
+    }
+
+    // runs until every block taken in has left the last stage
+    void drain() {
+        for (int i = 0; i < stageCount - 1; i++) {
+            tick(0);
+        }
+    }
+
+    // blocks between a block entering stage 0 and its output leaving the last stage
+    int latencyBlocks() const {
+        return stageCount - 1;
+    }
+
+    int stageCountUsed() const {
+        return stageCount;
+    }
+
+    int crossStageQueueCount() const {
+        return static_cast<int>(queues.size());
+    }
+
+private:
+    // count == 0: no new block, the stages still work on the blocks in flight
+    void tick(int count) {
+        // refolded while no stage runs, blocks still in flight read the new constants
+        plan.refreshChangedConstants();
+        head++;
+        blockCounts[head % stageCount] = count;
+        for (auto& queue : queues) {
+            queue->advance(head);
+        }
+        finished.store(0, std::memory_order_relaxed);
+        nextStage.store(1, std::memory_order_relaxed);
+
+        for (int stage = 1; stage < stageCount; stage++) {
+            pool.enqueue();
+        }
+        runStage(0);
+
+        int spins = 0;
+        while (finished.load(std::memory_order_acquire) < stageCount - 1) {
+            if (++spins > spinLimit) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    // stage s works on the block that entered s ticks ago, if there was one
+    void runStage(int stage) {
+        int block = head - stage;
+        if (block < 0) {
+            return;
+        }
+        int count = blockCounts[block % stageCount];
+        if (count == 0) {
+            return;
+        }
+        for (int step = stageOffsets[stage]; step < stageOffsets[stage + 1]; step++) {
+            plan.runStep(step, count);
+            for (auto queue : queueOfStep[step]) {
+                queue->push(head, count);
+            }
+        }
+        for (auto node : stageFeedback[stage]) {
+            node->commitOutput(count);
+        }
+    }
+
+    static constexpr int spinLimit = 1 << 10;
+
+    ExecutionPlan plan;
+    int stageCount = 1;
+    // stage s runs steps [stageOffsets[s] .. stageOffsets[s + 1])
+    std::vector<int> stageOffsets;
+    std::vector<std::unique_ptr<AbstractBlockQueue>> queues;
+    std::vector<std::vector<AbstractBlockQueue*>> queueOfStep;
+    std::vector<std::vector<AbstractNode*>> stageFeedback;
+
+    // block counts of the blocks in flight, by block index modulo stageCount, 0 = no block
+    std::vector<int> blockCounts;
+    int head = -1;
+    std::atomic<int> finished = 0;
+    std::atomic<int> nextStage = 1;
+
+    // declared last: joins the workers before anything they touch is destroyed
+    ThreadPool pool;
+};
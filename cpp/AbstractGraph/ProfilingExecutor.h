@@ -0,0 +1,179 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "Graph.h"
+
+// opt-in per-node profiler, build with -DABSTRACT_GRAPH_PROFILE=1
+// - disabled (default): ProfilingExecutor only runs the plan, no timer reads, no histograms, report() says so
+// - enabled: every step is timed with the TSC (rdtsc / rdtscp), the sample goes into that step's
+//   preallocated log-linear histogram, nothing allocates while running
+// - fused chain links are timed with the step they run in, folded constants are not timed
+#ifndef ABSTRACT_GRAPH_PROFILE
+#define ABSTRACT_GRAPH_PROFILE 0
+#endif
+
+#if ABSTRACT_GRAPH_PROFILE
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#include <algorithm>
+#include <bit>
+#include <thread>
+#endif
+
+struct ProfilingExecutor {
+    ProfilingExecutor(const ExecutionPlan& plan, int sampleRate)
+        : plan(plan), sampleRate(sampleRate) {
+#if ABSTRACT_GRAPH_PROFILE
+        histograms.assign(plan.steps.size() * bucketCount, 0);
+        maxCycles.assign(plan.steps.size(), 0);
+        totalCycles.assign(plan.steps.size(), 0);
+        cyclesPerNanosecond = calibrate();
+#endif
+    }
+
+    // one sample
+    void run() {
+        execute(0);
+    }
+
+    // one block, count must not exceed the size given to Graph::prepareBlock()
+    void runBlock(int count) {
+        execute(count);
+    }
+
+    // p50 / p99 / max per node, and each node's share of the real-time budget of one tick/block
+    // - percentiles are histogram bucket upper bounds, within 12.5%
+    void report() const {
+#if ABSTRACT_GRAPH_PROFILE
+        int samplesPerRun = lastCount == 0 ? 1 : lastCount;
+        double budgetNanoseconds = 1e9 * samplesPerRun / sampleRate;
+        printf("\nprofile | %i runs of %i samples @ %i Hz, budget %.0f ns | %.2f cycles/ns",
+            static_cast<int>(runCount), samplesPerRun, sampleRate, budgetNanoseconds, cyclesPerNanosecond);
+        printf("\n%-12s %10s %10s %10s %8s %8s", "node", "p50 ns", "p99 ns", "max ns", "mean %", "p99 %");
+        for (size_t step = 0; step < plan.steps.size(); step++) {
+            double p50 = percentile(step, 0.50) / cyclesPerNanosecond;
+            double p99 = percentile(step, 0.99) / cyclesPerNanosecond;
+            double max = maxCycles[step] / cyclesPerNanosecond;
+            double mean = runCount == 0 ? 0.0 : totalCycles[step] / cyclesPerNanosecond / runCount;
+            const CompiledStep& compiled = plan.steps[step];
+            printf("\n%-12s %10.0f %10.0f %10.0f %8.3f %8.3f%s",
+                compiled.node->name.c_str(), p50, p99, max,
+                100.0 * mean / budgetNanoseconds,
+                100.0 * p99 / budgetNanoseconds,
+                compiled.chainEnd > compiled.chainBegin ? " (+chain)" : "");
+        }
+#else
+        printf("\nprofile | disabled, build with -DABSTRACT_GRAPH_PROFILE=1");
+#endif
+    }
+
+private:
+    void execute(int count) {
+#if ABSTRACT_GRAPH_PROFILE
+        plan.refreshChangedConstants();
+        lastCount = count;
+        runCount++;
+        for (int step = 0; step < static_cast<int>(plan.steps.size()); step++) {
+            uint64_t start = readStart();
+            plan.runStep(step, count);
+            record(step, readEnd() - start);
+        }
+        plan.commitFeedback(count);
+#else
+        if (count == 0) {
+            plan.run();
+        } else {
+            plan.runBlock(count);
+        }
+#endif
+    }
+
+    const ExecutionPlan& plan;
+    int sampleRate;
+
+#if ABSTRACT_GRAPH_PROFILE
+    // log-linear buckets: values below 16 cycles exact, above that 8 buckets per power of two
+    static constexpr int subBucketBits = 3;
+    static constexpr int linearBuckets = 16;
+    static constexpr int bucketCount = linearBuckets + (64 - 4) * (1 << subBucketBits);
+
+    static int bucketOf(uint64_t cycles) {
+        if (cycles < linearBuckets) {
+            return static_cast<int>(cycles);
+        }
+        int exponent = std::bit_width(cycles) - 1;
+        int mantissa = static_cast<int>((cycles >> (exponent - subBucketBits)) & ((1 << subBucketBits) - 1));
+        return linearBuckets + (exponent - 4) * (1 << subBucketBits) + mantissa;
+    }
+
+    static uint64_t bucketUpperBound(int bucket) {
+        if (bucket < linearBuckets) {
+            return static_cast<uint64_t>(bucket);
+        }
+        int exponent = 4 + (bucket - linearBuckets) / (1 << subBucketBits);
+        uint64_t mantissa = (bucket - linearBuckets) % (1 << subBucketBits);
+        return (((1 << subBucketBits) + mantissa + 1) << (exponent - subBucketBits)) - 1;
+    }
+
+    void record(int step, uint64_t cycles) {
+        histograms[step * bucketCount + bucketOf(cycles)]++;
+        maxCycles[step] = std::max(maxCycles[step], cycles);
+        totalCycles[step] += cycles;
+    }
+
+    double percentile(size_t step, double fraction) const {
+        uint64_t rank = static_cast<uint64_t>(fraction * static_cast<double>(runCount));
+        uint64_t seen = 0;
+        for (int bucket = 0; bucket < bucketCount; bucket++) {
+            seen += histograms[step * bucketCount + bucket];
+            if (seen > rank) {
+                return static_cast<double>(std::min(bucketUpperBound(bucket), maxCycles[step]));
+            }
+        }
+        return static_cast<double>(maxCycles[step]);
+    }
+
+    // lfence keeps earlier work from leaking into the start, rdtscp waits for the step to retire
+    static uint64_t readStart() {
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+        _mm_lfence();
+        return __rdtsc();
+#else
+        return std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+    }
+
+    static uint64_t readEnd() {
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+        unsigned int processor;
+        uint64_t cycles = __rdtscp(&processor);
+        _mm_lfence();
+        return cycles;
+#else
+        return std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+    }
+
+    // TSC ticks per nanosecond against steady_clock, once per executor
+    static double calibrate() {
+        auto clockStart = std::chrono::steady_clock::now();
+        uint64_t start = readStart();
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        uint64_t end = readEnd();
+        auto clockEnd = std::chrono::steady_clock::now();
+        auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(clockEnd - clockStart).count();
+        return static_cast<double>(end - start) / static_cast<double>(nanoseconds);
+    }
+
+    std::vector<uint32_t> histograms;
+    std::vector<uint64_t> maxCycles;
+    std::vector<uint64_t> totalCycles;
+    double cyclesPerNanosecond = 1.0;
+    uint64_t runCount = 0;
+    int lastCount = 0;
+#endif
+};
@@ -0,0 +1,119 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "../misc/ThreadPool.h"
+#include "Graph.h"
+#include "StaticPartition.h"
+
+// runs a compiled plan on a precomputed StaticSchedule
+// - every worker walks its own step list, no queues, no counters, no stealing
+// - cut edges are the only synchronisation: a signalling step publishes the tick/block's epoch on its own
+//   cache line, a waiting worker spins on it (yielding after spinLimit)
+// - workers sleep on the pool semaphore between ticks/blocks, like the other executors
+//   a woken thread claims the next worker slot, so a thread that finishes early and takes a second token
+//   runs another slot instead of leaving one unclaimed; workers without steps get no thread at all
+// - the schedule (kept by value) must come from the same plan, compile() again means partitionPlan() again
+struct StaticExecutor {
+    StaticExecutor(const ExecutionPlan& plan, StaticSchedule schedule)
+        : plan(plan),
+          schedule(std::move(schedule)),
+          flags(std::make_unique<Flag[]>(plan.steps.size())),
+          pool(0) {
+
+        for (int worker = 1; worker < this->schedule.workerCount; worker++) {
+            if (this->schedule.workerOffsets[worker] != this->schedule.workerOffsets[worker + 1]) {
+                threadWorkers.emplace_back(worker);
+            }
+        }
+        for (size_t thread = 0; thread < threadWorkers.size(); thread++) {
+            pool.addWorker([this] {
+                while (true) {
+                    pool.newWorkSemaphore.acquire();
+                    if (pool.done) {
+                        break;
+                    }
+                    work(threadWorkers[nextWorker.fetch_add(1, std::memory_order_relaxed)]);
+                    finished.fetch_add(1, std::memory_order_release);
+                }
+            });
+        }
+    }
+
+    // one sample
+    void run() {
+        execute(0);
+    }
+
+    // one block, count must not exceed the size given to Graph::prepareBlock()
+    void runBlock(int count) {
+        execute(count);
+    }
+
+private:
+    struct alignas(64) Flag {
+        std::atomic<int> epoch = 0;
+    };
+
+    void execute(int count) {
+        plan.refreshChangedConstants();
+        blockCount = count;
+        // published to the workers by the semaphore release
+        epoch++;
+        finished.store(0, std::memory_order_relaxed);
+        nextWorker.store(0, std::memory_order_relaxed);
+
+        int threadCount = static_cast<int>(threadWorkers.size());
+        for (int thread = 0; thread < threadCount; thread++) {
+            pool.enqueue();
+        }
+        work(0);
+
+        int spins = 0;
+        while (finished.load(std::memory_order_acquire) < threadCount) {
+            if (++spins > spinLimit) {
+                std::this_thread::yield();
+            }
+        }
+        plan.commitFeedback(blockCount);
+    }
+
+    void work(int worker) {
+        for (int i = schedule.workerOffsets[worker]; i < schedule.workerOffsets[worker + 1]; i++) {
+            for (int w = schedule.waitOffsets[i]; w < schedule.waitOffsets[i + 1]; w++) {
+                std::atomic<int>& flag = flags[schedule.waits[w]].epoch;
+                int spins = 0;
+                while (flag.load(std::memory_order_acquire) != epoch) {
+                    if (++spins > spinLimit) {
+                        std::this_thread::yield();
+                    }
+                }
+            }
+
+            int step = schedule.steps[i];
+            plan.runStep(step, blockCount);
+            if (schedule.signals[step]) {
+                flags[step].epoch.store(epoch, std::memory_order_release);
+            }
+        }
+    }
+
+    static constexpr int spinLimit = 1 << 10;
+
+    const ExecutionPlan& plan;
+    StaticSchedule schedule;
+    // workers 1.. that have steps, one pool thread each
+    std::vector<int> threadWorkers;
+    std::unique_ptr<Flag[]> flags;
+
+    int blockCount = 0;
+    int epoch = 0;
+    std::atomic<int> finished = 0;
+    std::atomic<int> nextWorker = 0;
+
+    // declared last: joins the workers before anything they touch is destroyed
+    ThreadPool pool;
+};
@@ -0,0 +1,95 @@
+#pragma once
+#include <concepts>
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+
+#include "FrameBase.h"
+#include "NodeBase.h"
+
+// compile-time graph for patches that never change at runtime
+// - Chain<A, B, ...>: A feeds B feeds ...
+// - Mix<A, B, ...>:   every branch gets the same input, outputs are summed in declaration order
+// - a part is a concrete Node<InputT, OutputT> subclass or a nested Chain / Mix
+// - every tick is a qualified call into the concrete node, nothing virtual and no casts,
+//   so the whole graph is one function the compiler can inline end to end
+template <typename... Parts>
+struct Chain {};
+
+template <typename... Parts>
+struct Mix {};
+
+template <typename NodeT>
+struct StaticPart {
+    static_assert(std::is_base_of_v<Node<typename NodeT::InputType, typename NodeT::OutputType>, NodeT>,
+        "static graph parts are Node subclasses, Chain or Mix");
+
+    using Input = typename NodeT::InputType;
+    using Output = typename NodeT::OutputType;
+
+    NodeT node { "static" };
+
+    Output tick(const Input& input) {
+        return node.template tickAs<NodeT>(input);
+    }
+
+    void reset() {
+        node.reset();
+    }
+};
+
+template <typename First, typename... Rest>
+struct StaticPart<Chain<First, Rest...>> {
+    using Input = typename StaticPart<First>::Input;
+    using Output = typename std::tuple_element_t<sizeof...(Rest), std::tuple<StaticPart<First>, StaticPart<Rest>...>>::Output;
+
+    std::tuple<StaticPart<First>, StaticPart<Rest>...> parts;
+
+    Output tick(const Input& input) {
+        return tickFrom<0>(input);
+    }
+
+    void reset() {
+        std::apply([](auto&... part) { (part.reset(), ...); }, parts);
+    }
+
+private:
+    template <std::size_t I, typename In>
+    auto tickFrom(const In& input) {
+        auto& part = std::get<I>(parts);
+        static_assert(std::same_as<In, typename std::remove_reference_t<decltype(part)>::Input>,
+            "Chain: output frame of a part must match the input frame of the next");
+        if constexpr (I < sizeof...(Rest)) {
+            return tickFrom<I + 1>(part.tick(input));
+        } else {
+            return part.tick(input);
+        }
+    }
+};
+
+template <typename First, typename... Rest>
+struct StaticPart<Mix<First, Rest...>> {
+    using Input = typename StaticPart<First>::Input;
+    using Output = typename StaticPart<First>::Output;
+
+    static_assert((std::same_as<Input, typename StaticPart<Rest>::Input> && ...),
+        "Mix: every branch takes the same input frame");
+    static_assert((std::same_as<Output, typename StaticPart<Rest>::Output> && ...),
+        "Mix: every branch produces the same output frame");
+
+    std::tuple<StaticPart<First>, StaticPart<Rest>...> parts;
+
+    Output tick(const Input& input) {
+        Output frame;
+        std::apply([&](auto&... part) { ((frame += part.tick(input)), ...); }, parts);
+        return frame;
+    }
+
+    void reset() {
+        std::apply([](auto&... part) { (part.reset(), ...); }, parts);
+    }
+};
+
+// the top level of a static graph is a chain
+template <typename... Parts>
+struct StaticGraph : public StaticPart<Chain<Parts...>> {};
@@ -0,0 +1,201 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <numeric>
+#include <vector>
+
+#include "Graph.h"
+
+// offline assignment of a compiled plan's steps to workers
+// - worker w runs steps[workerOffsets[w] .. workerOffsets[w + 1]) in that order, nothing is decided while running
+// - before steps[i] runs, its worker waits for the steps in waits[waitOffsets[i] .. waitOffsets[i + 1]),
+//   those are the only cross-thread handoffs, signals[step] marks the steps some other worker waits for
+// - start / finish are the predicted times in ns from the start of a tick/block, makespan the last finish
+struct StaticSchedule {
+    int workerCount = 0;
+    std::vector<int> workerOffsets;
+    std::vector<int> steps;
+    std::vector<int> waitOffsets;
+    std::vector<int> waits;
+
+    // indexed by plan step
+    std::vector<int> workerOf;
+    std::vector<char> signals;
+    std::vector<double> start;
+    std::vector<double> finish;
+
+    double makespan = 0.0;
+    // producer -> consumer pairs on different workers, before redundant waits are dropped
+    int cutEdges = 0;
+
+    int handoffCount() const {
+        return static_cast<int>(waits.size());
+    }
+
+    // one line per step in worker order: predicted start / finish and the steps waited for
+    void print(const ExecutionPlan& plan) const {
+        printf("\nstatic schedule | %i workers, %i steps, %i cut edges, %i handoffs, predicted makespan %.0f ns",
+            workerCount, static_cast<int>(steps.size()), cutEdges, handoffCount(), makespan);
+        for (int worker = 0; worker < workerCount; worker++) {
+            printf("\nworker %i:", worker);
+            for (int i = workerOffsets[worker]; i < workerOffsets[worker + 1]; i++) {
+                int step = steps[i];
+                printf("\n  %-12s %9.0f .. %9.0f ns", plan.steps[step].node->name.c_str(), start[step], finish[step]);
+                for (int w = waitOffsets[i]; w < waitOffsets[i + 1]; w++) {
+                    printf("%s%s@%i", w == waitOffsets[i] ? " | waits " : ", ",
+                        plan.steps[waits[w]].node->name.c_str(), workerOf[waits[w]]);
+                }
+            }
+        }
+    }
+};
+
+// mean ns per step over `runs` ticks (count == 0) or blocks, single threaded
+// - one warm-up run first, fused chain links count towards their step, folded constants are not steps
+inline std::vector<double> measureStepCosts(const ExecutionPlan& plan, int count, int runs) {
+    int stepCount = static_cast<int>(plan.steps.size());
+    std::vector<double> costs(stepCount, 0.0);
+    for (int run = 0; run <= runs; run++) {
+        for (int step = 0; step < stepCount; step++) {
+            auto start = std::chrono::steady_clock::now();
+            plan.runStep(step, count);
+            auto end = std::chrono::steady_clock::now();
+            if (run > 0) {
+                costs[step] += std::chrono::duration<double, std::nano>(end - start).count();
+            }
+        }
+        plan.commitFeedback(count);
+    }
+    for (auto& cost : costs) {
+        cost /= std::max(1, runs);
+    }
+    return costs;
+}
+
+// critical-path list scheduling (HEFT without insertion)
+// - upward rank: a step's cost plus the longest rank among its consumers, a handoff counted on every edge
+// - steps in decreasing rank go to the worker where they finish first, paying handoffCost for every input
+//   produced on another worker; appending keeps each worker's order a subsequence of one topological order,
+//   so waiting on other workers can't deadlock
+// - falls back to a single worker when that is predicted to finish no later
+// - waits: per input worker only the latest producer, and none that an earlier wait on that worker already covers
+// - costs[step] in ns, e.g. from measureStepCosts() or declared
+inline StaticSchedule partitionPlan(const ExecutionPlan& plan, const std::vector<double>& costs, int workerCount, double handoffCost) {
+    int stepCount = static_cast<int>(plan.steps.size());
+    StaticSchedule schedule;
+    schedule.workerCount = workerCount < 1 ? 1 : workerCount;
+    schedule.workerOf.assign(stepCount, 0);
+    schedule.signals.assign(stepCount, 0);
+    schedule.start.assign(stepCount, 0.0);
+    schedule.finish.assign(stepCount, 0.0);
+
+    // producers of every step, the transpose of the plan's consumer CSR
+    std::vector<int> producerOffsets(stepCount + 1, 0);
+    for (int consumer : plan.consumers) {
+        producerOffsets[consumer + 1]++;
+    }
+    for (int i = 0; i < stepCount; i++) {
+        producerOffsets[i + 1] += producerOffsets[i];
+    }
+    std::vector<int> producers(producerOffsets.back());
+    std::vector<int> cursor(producerOffsets.begin(), producerOffsets.end() - 1);
+    for (int step = 0; step < stepCount; step++) {
+        for (int c = plan.consumerOffsets[step]; c < plan.consumerOffsets[step + 1]; c++) {
+            producers[cursor[plan.consumers[c]]++] = step;
+        }
+    }
+
+    // consumers always sit in a later level, so one backwards pass sees them first
+    std::vector<double> rank(stepCount, 0.0);
+    for (int step = stepCount - 1; step >= 0; step--) {
+        double longest = 0.0;
+        for (int c = plan.consumerOffsets[step]; c < plan.consumerOffsets[step + 1]; c++) {
+            longest = std::max(longest, handoffCost + rank[plan.consumers[c]]);
+        }
+        rank[step] = costs[step] + longest;
+    }
+    // ties keep plan order, which is topological
+    std::vector<int> order(stepCount);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&rank](int a, int b) {
+        return rank[a] > rank[b];
+    });
+
+    std::vector<std::vector<int>> workerSteps;
+    auto listSchedule = [&](int usedWorkers) {
+        std::vector<double> workerReady(usedWorkers, 0.0);
+        workerSteps.assign(schedule.workerCount, {});
+        schedule.makespan = 0.0;
+        for (int step : order) {
+            int best = 0;
+            double bestStart = 0.0;
+            double bestFinish = 0.0;
+            for (int worker = 0; worker < usedWorkers; worker++) {
+                double start = workerReady[worker];
+                for (int p = producerOffsets[step]; p < producerOffsets[step + 1]; p++) {
+                    int producer = producers[p];
+                    double ready = schedule.finish[producer] + (schedule.workerOf[producer] == worker ? 0.0 : handoffCost);
+                    start = std::max(start, ready);
+                }
+                double finish = start + costs[step];
+                if (worker == 0 || finish < bestFinish) {
+                    best = worker;
+                    bestStart = start;
+                    bestFinish = finish;
+                }
+            }
+            schedule.workerOf[step] = best;
+            schedule.start[step] = bestStart;
+            schedule.finish[step] = bestFinish;
+            workerReady[best] = bestFinish;
+            workerSteps[best].emplace_back(step);
+            schedule.makespan = std::max(schedule.makespan, bestFinish);
+        }
+    };
+    // greedy placement can lose to running everything on one worker when handoffs cost more than the steps
+    listSchedule(schedule.workerCount);
+    if (std::accumulate(costs.begin(), costs.end(), 0.0) <= schedule.makespan) {
+        listSchedule(1);
+    }
+
+    // position of every step in its worker's list
+    std::vector<int> position(stepCount, 0);
+    for (auto& list : workerSteps) {
+        for (int i = 0; i < static_cast<int>(list.size()); i++) {
+            position[list[i]] = i;
+        }
+    }
+
+    schedule.workerOffsets.assign(1, 0);
+    schedule.waitOffsets.assign(1, 0);
+    for (int worker = 0; worker < schedule.workerCount; worker++) {
+        // highest position already waited for on every other worker
+        std::vector<int> covered(schedule.workerCount, -1);
+        std::vector<int> latest(schedule.workerCount, -1);
+        for (int step : workerSteps[worker]) {
+            std::fill(latest.begin(), latest.end(), -1);
+            for (int p = producerOffsets[step]; p < producerOffsets[step + 1]; p++) {
+                int producer = producers[p];
+                int from = schedule.workerOf[producer];
+                if (from == worker) {
+                    continue;
+                }
+                schedule.cutEdges++;
+                latest[from] = std::max(latest[from], position[producer]);
+            }
+            for (int from = 0; from < schedule.workerCount; from++) {
+                if (latest[from] > covered[from]) {
+                    int producer = workerSteps[from][latest[from]];
+                    schedule.waits.emplace_back(producer);
+                    schedule.signals[producer] = 1;
+                    covered[from] = latest[from];
+                }
+            }
+            schedule.steps.emplace_back(step);
+            schedule.waitOffsets.emplace_back(static_cast<int>(schedule.waits.size()));
+        }
+        schedule.workerOffsets.emplace_back(static_cast<int>(schedule.steps.size()));
+    }
+    return schedule;
+}
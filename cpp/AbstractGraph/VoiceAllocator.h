@@ -0,0 +1,39 @@
+#pragma once
+
+#include <bit>
+
+#include "LaneFrame.h"
+
+
+// voices over `Banks` instances of an N lane polyphonic subgraph
+// - voice v is lane v % N of bank v / N
+// - allocating or releasing a voice flips one lane of one bank's mask, the graph itself never changes
+template <int N, int Banks>
+struct VoiceAllocator {
+    static constexpr int voiceCount = N * Banks;
+    LaneMask<N> masks[Banks];
+
+    // lowest free voice, -1 when every voice is sounding
+    int allocate() {
+        for (int bank = 0; bank < Banks; bank++) {
+            if (!masks[bank].full()) {
+                int lane = std::countr_one(masks[bank].bits);
+                masks[bank].set(lane, true);
+                return bank * N + lane;
+            }
+        }
+        return -1;
+    }
+
+    void release(int voice) {
+        masks[voice / N].set(voice % N, false);
+    }
+
+    int activeCount() const {
+        int count = 0;
+        for (auto& mask : masks) {
+            count += std::popcount(mask.bits);
+        }
+        return count;
+    }
+};
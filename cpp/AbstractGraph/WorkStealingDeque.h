@@ -0,0 +1,80 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+// Chase-Lev work stealing deque of step indices
+// - the owner pushes and pops at the bottom, thieves steal from the top
+// - fixed power of two capacity: every step is pushed at most once per tick, so it never grows
+// - reset() is only valid while no other thread touches the deque
+struct WorkStealingDeque {
+    static constexpr int empty = -1;
+
+    explicit WorkStealingDeque(int minCapacity = 1) {
+        int64_t capacity = 1;
+        while (capacity < minCapacity) {
+            capacity <<= 1;
+        }
+        mask = capacity - 1;
+        buffer = std::make_unique<std::atomic<int>[]>(capacity);
+    }
+
+    void reset() {
+        top.store(0, std::memory_order_relaxed);
+        bottom.store(0, std::memory_order_relaxed);
+    }
+
+    // owner only
+    void push(int item) {
+        int64_t b = bottom.load(std::memory_order_relaxed);
+        buffer[b & mask].store(item, std::memory_order_relaxed);
+        bottom.store(b + 1, std::memory_order_release);
+    }
+
+    // owner only
+    int pop() {
+        int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top.load(std::memory_order_relaxed);
+
+        if (t > b) {
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return empty;
+        }
+
+        int item = buffer[b & mask].load(std::memory_order_relaxed);
+        if (t == b) {
+            // last item, race the thieves for it
+            if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                item = empty;
+            }
+            bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return item;
+    }
+
+    // any thread
+    int steal() {
+        int64_t t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = bottom.load(std::memory_order_acquire);
+
+        if (t >= b) {
+            return empty;
+        }
+
+        int item = buffer[t & mask].load(std::memory_order_relaxed);
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return empty;
+        }
+        return item;
+    }
+
+private:
+    // top and bottom on their own cache lines, thieves hammer top while the owner works the bottom
+    alignas(64) std::atomic<int64_t> top = 0;
+    alignas(64) std::atomic<int64_t> bottom = 0;
+    int64_t mask;
+    std::unique_ptr<std::atomic<int>[]> buffer;
+};
@@ -0,0 +1,153 @@
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "FrameBase.h"
+#include "NodeBase.h"
+#include "CustomTypes.h"
+#include "Graph.h"
+#include "GraphOperators.h"
+
+// one random DAG, built twice:
+// - scattered: nodes allocated one by one on the heap, in random order, with padding in between
+// - arena:     nodes created with Graph::emplace, relocated into schedule order by prepare()
+//
+// node kinds by index:
+// - [0, sourceCount)                 SourceNode
+// - [sourceCount, 2 * sourceCount)   UpcastNode, fed by its source
+// - [2 * sourceCount, nodeCount)     DecayNode, fed by 2 random earlier float nodes
+struct Topology {
+    int nodeCount;
+    int sourceCount;
+    std::vector<std::pair<int, int>> decayInputs;
+
+    Topology(int nodeCount, unsigned seed) : nodeCount(nodeCount), sourceCount(std::max(1, nodeCount / 100)) {
+        std::mt19937 random(seed);
+        for (int i = 2 * sourceCount; i < nodeCount; i++) {
+            std::uniform_int_distribution<int> earlier(sourceCount, i - 1);
+            decayInputs.emplace_back(earlier(random), earlier(random));
+        }
+    }
+};
+
+// creates the nodes through `make` in `creationOrder`, then wires them in index order
+template <typename Make>
+void build(const Topology& topology, const std::vector<int>& creationOrder, Make make) {
+    std::vector<SourceNode*> sources(topology.sourceCount);
+    std::vector<Node<FloatFrame, FloatFrame>*> floats(topology.nodeCount);
+    std::vector<UpcastNode*> upcasts(topology.nodeCount);
+
+    for (int i : creationOrder) {
+        if (i < topology.sourceCount) {
+            sources[i] = &make.template operator()<SourceNode>();
+        } else if (i < 2 * topology.sourceCount) {
+            upcasts[i] = &make.template operator()<UpcastNode>();
+        } else {
+            floats[i] = &make.template operator()<DecayNode>();
+        }
+    }
+
+    auto input = [&](int index) -> Node<IntFrame, FloatFrame>* {
+        return index < 2 * topology.sourceCount ? upcasts[index] : nullptr;
+    };
+
+    for (int i = 0; i < topology.sourceCount; i++) {
+        *sources[i] >> *upcasts[topology.sourceCount + i];
+    }
+    for (int i = 2 * topology.sourceCount; i < topology.nodeCount; i++) {
+        auto [a, b] = topology.decayInputs[i - 2 * topology.sourceCount];
+        for (int from : { a, b }) {
+            if (auto upcast = input(from)) {
+                *upcast >> *floats[i];
+            } else {
+                *floats[from] >> *floats[i];
+            }
+        }
+    }
+}
+
+int64_t runPlan(Graph& graph, int ticks) {
+    graph.prepare();
+    graph.compile();
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < ticks; i++) {
+        graph.plan.run();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+}
+
+void report(const char* label, int nodeCount, int ticks, int64_t microseconds, float result) {
+    double nodesPerSecond = static_cast<double>(nodeCount) * ticks / (static_cast<double>(microseconds) / 1e6);
+    printf("\nTime taken | %12s: %6i milliseconds | %7.1f M nodes/second | result %f",
+        label,
+        static_cast<int>(microseconds / 1000),
+        nodesPerSecond / 1e6,
+        result);
+}
+
+int main() {
+    int64_t nodeTicks = 50'000'000;
+
+    for (int nodeCount : { 10'000, 30'000, 100'000 }) {
+        Topology topology(nodeCount, 1);
+        int ticks = static_cast<int>(nodeTicks / nodeCount);
+        printf("\n\nnodes: %i, ticks: %i", nodeCount, ticks);
+
+        std::vector<int> creationOrder(nodeCount);
+        std::iota(creationOrder.begin(), creationOrder.end(), 0);
+        std::vector<int> shuffledOrder = creationOrder;
+        std::shuffle(shuffledOrder.begin(), shuffledOrder.end(), std::mt19937(2));
+
+        // SCATTERED
+        {
+            Graph graph;
+            graph.setContext();
+            std::mt19937 random(3);
+            std::uniform_int_distribution<int> paddingSize(16, 512);
+            std::vector<std::unique_ptr<std::byte[]>> padding;
+            std::vector<std::unique_ptr<SourceNode>> sourceNodes;
+            std::vector<std::unique_ptr<UpcastNode>> upcastNodes;
+            std::vector<std::unique_ptr<DecayNode>> decayNodes;
+
+            build(topology, shuffledOrder, [&]<typename NodeT>() -> NodeT& {
+                padding.emplace_back(std::make_unique<std::byte[]>(paddingSize(random)));
+                auto node = std::make_unique<NodeT>("node");
+                NodeT& created = *node;
+                graph.nodes.emplace_back(node.get());
+                if constexpr (std::is_same_v<NodeT, SourceNode>) {
+                    sourceNodes.emplace_back(std::move(node));
+                } else if constexpr (std::is_same_v<NodeT, UpcastNode>) {
+                    upcastNodes.emplace_back(std::move(node));
+                } else {
+                    decayNodes.emplace_back(std::move(node));
+                }
+                return created;
+            });
+
+            int64_t duration = runPlan(graph, ticks);
+            report("scattered", nodeCount, ticks, duration, dynamic_cast<NodeOutput<FloatFrame>*>(graph.nodes[graph.schedule.nodeIndices.back()])->getResult().data);
+        }
+
+        // ARENA
+        {
+            Graph graph;
+            graph.setContext();
+
+            build(topology, shuffledOrder, [&]<typename NodeT>() -> NodeT& {
+                return graph.emplace<NodeT>("node");
+            });
+
+            int64_t duration = runPlan(graph, ticks);
+            report("arena", nodeCount, ticks, duration, dynamic_cast<NodeOutput<FloatFrame>*>(graph.nodes[graph.schedule.nodeIndices.back()])->getResult().data);
+        }
+    }
+
+    printf("\n");
+    return 0;
+}
@@ -0,0 +1,160 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <utility>
+#include <vector>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#include "FrameBase.h"
+#include "NodeBase.h"
+#include "CustomTypes.h"
+#include "Graph.h"
+#include "GraphBuilder.h"
+
+// construction cost of a large graph, ~1M edges
+// - maps:    Graph::emplace + Graph::connect, i.e. what operator>> does (adjacency maps, type map ports, instance lambdas)
+// - builder: GraphBuilder::emplace + connect by index, one counting sort into the CSR
+// - same nodes and edges in the same order for both, then prepare + compile, the plans and results must match
+// - the sums grow with depth, so the result is read from the first node of level 3 rather than the last one
+// - heap is glibc's in-use byte count, so it covers everything the graph allocated, nodes included
+//   mmapped chunks (hblkhd, the large vectors) are counted too, uordblks alone misses them
+constexpr int workNodeCount = 100000;
+constexpr int fanIn = 10;
+constexpr int window = 1000;
+
+double millisecondsSince(std::chrono::high_resolution_clock::time_point start) {
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+double heapMegabytes() {
+#ifdef __GLIBC__
+    struct mallinfo2 info = mallinfo2();
+    return static_cast<double>(info.uordblks + info.hblkhd) / (1024.0 * 1024.0);
+#else
+    return 0.0;
+#endif
+}
+
+// node 0 is the source, 1 the upcast, work nodes follow and read fanIn distinct work nodes of the previous `window`
+std::vector<std::pair<int, int>> generateEdges() {
+    std::mt19937 random(1);
+    std::vector<std::pair<int, int>> edges { { 0, 1 } };
+    edges.reserve(static_cast<size_t>(workNodeCount) * fanIn + 1);
+    std::vector<int> inputs;
+    for (int j = 0; j < workNodeCount; j++) {
+        int node = j + 2;
+        if (j == 0) {
+            edges.emplace_back(1, node);
+            continue;
+        }
+        int first = std::max(0, j - window);
+        int inputCount = std::min(fanIn, j - first);
+        inputs.clear();
+        while (static_cast<int>(inputs.size()) < inputCount) {
+            int input = first + static_cast<int>(random() % static_cast<unsigned>(j - first)) + 2;
+            if (std::find(inputs.begin(), inputs.end(), input) == inputs.end()) {
+                inputs.emplace_back(input);
+            }
+        }
+        for (int input : inputs) {
+            edges.emplace_back(input, node);
+        }
+    }
+    return edges;
+}
+
+struct Measurement {
+    double wire;
+    double prepare;
+    double compile;
+    double heap;
+};
+
+void print(const char* name, const Measurement& measurement) {
+    printf("\nTime taken | %12s: %8.1f ms wire, %8.1f ms prepare, %8.1f ms compile, %8.1f MB heap", name,
+        measurement.wire, measurement.prepare, measurement.compile, measurement.heap);
+}
+
+float runBlocks(Graph& graph) {
+    graph.prepareBlock(64);
+    for (int i = 0; i < 2; i++) {
+        graph.plan.runBlock(64);
+    }
+    printf(" | %i levels, %i steps", graph.schedule.levelCount(), static_cast<int>(graph.plan.steps.size()));
+    return static_cast<WorkNode*>(graph.nodes[graph.schedule.nodeIndices[graph.schedule.levelOffsets[3]]])->viewResult().data;
+}
+
+int main() {
+    std::vector<std::pair<int, int>> edges = generateEdges();
+    printf("\n\nnodes: %i, edges: %i", workNodeCount + 2, static_cast<int>(edges.size()));
+
+    float mapResult;
+    {
+        double heapBefore = heapMegabytes();
+        Measurement measurement;
+        Graph graph;
+        auto start = std::chrono::high_resolution_clock::now();
+        auto& source = graph.emplace<SourceNode>("source");
+        auto& upcast = graph.emplace<UpcastNode>("upcast");
+        graph.connect(source, upcast);
+        std::vector<WorkNode*> work;
+        work.reserve(workNodeCount);
+        for (int j = 0; j < workNodeCount; j++) {
+            work.emplace_back(&graph.emplace<WorkNode>("work"));
+            work.back()->work = 1;
+        }
+        graph.connect(upcast, *work[0]);
+        for (size_t e = 2; e < edges.size(); e++) {
+            graph.connect(*work[edges[e].first - 2], *work[edges[e].second - 2]);
+        }
+        measurement.wire = millisecondsSince(start);
+
+        start = std::chrono::high_resolution_clock::now();
+        graph.prepare();
+        measurement.prepare = millisecondsSince(start);
+        start = std::chrono::high_resolution_clock::now();
+        graph.compile();
+        measurement.compile = millisecondsSince(start);
+        measurement.heap = heapMegabytes() - heapBefore;
+        print("maps", measurement);
+        mapResult = runBlocks(graph);
+    }
+
+    float builderResult;
+    {
+        double heapBefore = heapMegabytes();
+        Measurement measurement;
+        Graph graph;
+        auto start = std::chrono::high_resolution_clock::now();
+        GraphBuilder builder(graph);
+        builder.reserve(workNodeCount + 2, static_cast<int>(edges.size()));
+        builder.emplace<SourceNode>("source");
+        builder.emplace<UpcastNode>("upcast");
+        for (int j = 0; j < workNodeCount; j++) {
+            builder.node<WorkNode>(builder.emplace<WorkNode>("work")).work = 1;
+        }
+        for (auto [source, destination] : edges) {
+            builder.connect(source, destination);
+        }
+        measurement.wire = millisecondsSince(start);
+
+        start = std::chrono::high_resolution_clock::now();
+        builder.build();
+        measurement.prepare = millisecondsSince(start);
+        start = std::chrono::high_resolution_clock::now();
+        graph.compile();
+        measurement.compile = millisecondsSince(start);
+        measurement.heap = heapMegabytes() - heapBefore;
+        print("builder", measurement);
+        builderResult = runBlocks(graph);
+    }
+
+    printf("\nresult: %f / %f", mapResult, builderResult);
+    printf("\n");
+    return 0;
+}
@@ -0,0 +1,105 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "FrameBase.h"
+#include "NodeBase.h"
+#include "CustomTypes.h"
+#include "LiveGraph.h"
+
+// an audio thread processes blocks of a LiveGraph while a control thread keeps patching it
+// - graph: SourceNode -> UpcastNode -> chain of DecayNodes -> mixer, plus UpcastNode -> mixer
+// - each edit inserts a DecayNode between the upcast and the mixer, publishes, then removes it again and publishes
+// - block times are measured on the audio thread, the same run without edits is the baseline
+struct BlockTimes {
+    std::vector<int64_t> nanoseconds;
+    float result = 0.0f;
+};
+
+BlockTimes runAudio(LiveGraph& live, Node<FloatFrame, FloatFrame>& mixer, int blockSize, int blockCount, std::atomic<bool>& running) {
+    BlockTimes times;
+    times.nanoseconds.reserve(blockCount);
+    for (int i = 0; i < blockCount; i++) {
+        auto start = std::chrono::high_resolution_clock::now();
+        live.processBlock(blockSize);
+        auto end = std::chrono::high_resolution_clock::now();
+        times.nanoseconds.emplace_back(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+    }
+    times.result = mixer.viewResult().data;
+    running = false;
+    return times;
+}
+
+void report(const char* label, BlockTimes times, int edits, int pending) {
+    std::sort(times.nanoseconds.begin(), times.nanoseconds.end());
+    int64_t total = 0;
+    for (auto time : times.nanoseconds) {
+        total += time;
+    }
+    printf("\nTime taken | %12s: %6i milliseconds | block mean %6i ns | p99 %7i ns | max %8i ns | edits %5i | pending plans %i | result %f",
+        label,
+        static_cast<int>(total / 1'000'000),
+        static_cast<int>(total / static_cast<int64_t>(times.nanoseconds.size())),
+        static_cast<int>(times.nanoseconds[times.nanoseconds.size() * 99 / 100]),
+        static_cast<int>(times.nanoseconds.back()),
+        edits,
+        pending,
+        times.result);
+}
+
+int main() {
+    int blockSize = 256;
+    int blockCount = 20'000;
+    int chainLength = 64;
+
+    for (bool editing : { false, true }) {
+        LiveGraph live(blockSize);
+        auto& source = live.addNode<SourceNode>("source");
+        auto& upcast = live.addNode<UpcastNode>("upcast");
+        auto& mixer = live.addNode<DecayNode>("mixer");
+        live.connect(source, upcast);
+
+        Node<FloatFrame, FloatFrame>* previous = nullptr;
+        for (int i = 0; i < chainLength; i++) {
+            auto& decay = live.addNode<DecayNode>("chain");
+            if (previous == nullptr) {
+                live.connect(upcast, decay);
+            } else {
+                live.connect(*previous, decay);
+            }
+            previous = &decay;
+        }
+        live.connect(*previous, mixer);
+        live.connect(upcast, mixer);
+        live.publish();
+
+        std::atomic<bool> running = true;
+        BlockTimes times;
+        std::thread audio([&]() {
+            times = runAudio(live, mixer, blockSize, blockCount, running);
+        });
+
+        int edits = 0;
+        while (editing && running) {
+            auto& branch = live.addNode<DecayNode>("branch");
+            live.connect(upcast, branch);
+            live.connect(branch, mixer);
+            live.publish();
+            edits++;
+
+            live.removeNode(&branch);
+            live.publish();
+            edits++;
+            std::this_thread::yield();
+        }
+        audio.join();
+
+        report(editing ? "live edits" : "no edits", times, edits, live.reclaim());
+    }
+
+    printf("\n");
+    return 0;
+}
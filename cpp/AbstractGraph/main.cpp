@@ -1,38 +1,205 @@
+#include <algorithm>
 #include <chrono>
 #include <vector>
 #include <functional>
 #include <map>
+#include <memory>
 
 #include "FrameBase.h"
 #include "NodeBase.h"
 #include "CustomTypes.h"
 #include "Graph.h"
+#include "GraphOperators.h"
+#include "DagExecutor.h"
+#include "ParallelExecutor.h"
+#include "PipelineExecutor.h"
+#include "ProfilingExecutor.h"
+#include "StaticExecutor.h"
+#include "StaticPartition.h"
+#include "StaticGraph.h"
+#include "VoiceAllocator.h"
 
 
-template <Frame X, Frame Y, Frame Z>
-Node<Y,Z> &operator>>(Node<X,Y> &sourceNode, Node<Y,Z> &destinationNode) {
-    Graph& graph = *(Graph::context);
-    graph.nodeAdjacencyMap[&destinationNode].emplace_back(&sourceNode);
+// runs the same blocks on executors with 1 .. maxWorkerCount workers, speedup is against 1 worker
+template <typename ExecutorFactory>
+void benchmarkWorkerCounts(Graph& graph, const char* label, int maxWorkerCount, int blockSize, int blockCount, ExecutorFactory createExecutor) {
+    printf("\n%s", label);
+    int64_t singleWorkerDuration = 0;
+    for (int workerCount = 1; workerCount <= maxWorkerCount; workerCount++) {
+        auto executor = createExecutor(workerCount);
 
-    // type map approach: auto register processing functions
-    if (!graph.typeMap.contains(sourceNode.getTypeIdInput())) {
-        graph.typeMap[sourceNode.getTypeIdInput()] = Graph::CreateTypeMapFunction(&sourceNode);
+        auto start = std::chrono::high_resolution_clock::now();
+
+        for (int i = 0; i < blockCount; i++) {
+            executor->runBlock(blockSize);
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+        if (workerCount == 1) {
+            singleWorkerDuration = duration;
+        }
+        printf("\nTime taken |   %2i workers: %6i milliseconds | speedup %5.2fx",
+            workerCount,
+            static_cast<int>(duration / 1000),
+            static_cast<double>(singleWorkerDuration) / static_cast<double>(duration));
+
+        printf("\nresult: %f", dynamic_cast<NodeOutput<FloatFrame>*>(graph.nodes.back())->getResult().data);
+        for (auto node : graph.nodes) {
+            node->reset();
+        }
+    }
+}
+
+// 64 voices as Banks instances of an N lane voice: oscillator -> envelope -> lane mix, all into one mixer
+// - 48 voices sounding, the other lanes masked off
+template <int N, int Banks>
+void benchmarkVoices(const char* label, int sampleRate, int blockSize, int blockCount) {
+    Graph voiceGraph;
+    Graph::ContextScope scope(voiceGraph);
+    VoiceAllocator<N, Banks> voices;
+    std::vector<std::unique_ptr<PolyOscillatorNode<N>>> oscillators;
+    std::vector<std::unique_ptr<PolyEnvelopeNode<N>>> envelopes;
+    std::vector<std::unique_ptr<LaneMixNode<N>>> laneMixes;
+    DecayNode voiceMixer("PV_MIX");
+
+    for (int bank = 0; bank < Banks; bank++) {
+        oscillators.emplace_back(std::make_unique<PolyOscillatorNode<N>>("PV_OSC"));
+        envelopes.emplace_back(std::make_unique<PolyEnvelopeNode<N>>("PV_ENV"));
+        laneMixes.emplace_back(std::make_unique<LaneMixNode<N>>("PV_LANES"));
+        oscillators.back()->mask = &voices.masks[bank];
+        envelopes.back()->mask = &voices.masks[bank];
+        *oscillators.back() >> *envelopes.back();
+        *envelopes.back() >> *laneMixes.back();
+        *laneMixes.back() >> voiceMixer;
     }
-    if (!graph.typeMap.contains(destinationNode.getTypeIdInput())) {
-        graph.typeMap[destinationNode.getTypeIdInput()] = Graph::CreateTypeMapFunction(&destinationNode);
+    for (int i = 0; i < 48; i++) {
+        int voice = voices.allocate();
+        oscillators[voice / N]->noteOn(voice % N, 110.f + 10.f * voice, static_cast<float>(sampleRate));
+        envelopes[voice / N]->noteOn(voice % N, 0.9999999f);
+    }
+
+    voiceGraph.prepare();
+    voiceGraph.compile();
+    voiceGraph.prepareBlock(blockSize);
+
+    auto voiceStart = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < blockCount; i++) {
+        voiceGraph.plan.runBlock(blockSize);
     }
+    auto voiceEnd = std::chrono::high_resolution_clock::now();
+    auto voiceDuration = std::chrono::duration_cast<std::chrono::milliseconds>(voiceEnd - voiceStart).count();
+    printf("\nTime taken | %s: %6i milliseconds | %3i steps, %2i voices",
+        label,
+        static_cast<int>(voiceDuration),
+        static_cast<int>(voiceGraph.plan.steps.size()),
+        voices.activeCount());
+    printf("\nresult: %f", voiceMixer.getResult().data);
+}
 
-    // instance map approach: auto register processing functions
-    // - InstanceMap(...) is casting the AbstractNode pointers and capturing the casted adjacency list each time.
-    // - can alternatively move a single iteration of the instance map setup into a graph.prepare() method.
-    
-    if (!graph.instanceMap.contains(&sourceNode)) {
-        std::vector<AbstractNode*> inputs = graph.nodeAdjacencyMap[&sourceNode];
-        graph.instanceMap[&sourceNode] = Graph::InstanceMap(&sourceNode, graph.nodeAdjacencyMap[&sourceNode]);
+// 16 voices of SN -> UN -> OSC -> VCA -> FILTER, modulated by two LFOs per voice (LFO_A -> VCA, LFO_B -> FILTER)
+// - 32 of the 83 nodes are LFOs, ticked every `divisor` samples, held or ramped in between
+void benchmarkControlRate(const char* label, int divisor, bool interpolate, int sampleRate, int blockSize, int blockCount) {
+    Graph rateGraph;
+    SourceNode& source = rateGraph.emplace<SourceNode>("CR_SN");
+    UpcastNode& upcast = rateGraph.emplace<UpcastNode>("CR_UN");
+    DecayNode& mixer = rateGraph.emplace<DecayNode>("CR_MIX");
+    rateGraph.connect(source, upcast);
+    for (int voice = 0; voice < 16; voice++) {
+        WorkNode& oscillator = rateGraph.emplace<WorkNode>("CR_OSC");
+        WorkNode& vca = rateGraph.emplace<WorkNode>("CR_VCA");
+        WorkNode& filter = rateGraph.emplace<WorkNode>("CR_FILTER");
+        oscillator.work = vca.work = filter.work = 16;
+        rateGraph.connect(upcast, oscillator);
+        rateGraph.connect(oscillator, vca);
+        rateGraph.connect(vca, filter);
+        rateGraph.connect(filter, mixer);
+        for (WorkNode* modulated : { &vca, &filter }) {
+            LfoNode& lfo = rateGraph.emplace<LfoNode>("CR_LFO");
+            lfo.increment = 2.f * std::numbers::pi_v<float> * (0.5f + 0.25f * voice) / static_cast<float>(sampleRate);
+            lfo.divisor = divisor;
+            lfo.interpolate = interpolate;
+            rateGraph.connect(upcast, lfo);
+            rateGraph.connect(lfo, *modulated);
+        }
+    }
+    // prepare() moves the nodes, find the mixer again by name
+    rateGraph.prepare();
+    rateGraph.compile();
+    rateGraph.prepareBlock(blockSize);
+    DecayNode* mixed = nullptr;
+    for (auto node : rateGraph.nodes) {
+        if (node->name == "CR_MIX") {
+            mixed = static_cast<DecayNode*>(node);
+        }
     }
-    graph.instanceMap[&destinationNode] = Graph::InstanceMap(&destinationNode, graph.nodeAdjacencyMap[&destinationNode]);
 
-    return destinationNode;
+    // every mixed sample goes into the checksum: a block ends on a tick, so its last sample is the same held or ramped
+    double checksum = 0.0;
+    auto rateStart = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < blockCount; i++) {
+        rateGraph.plan.runBlock(blockSize);
+        const FloatFrame* block = mixed->getBlock();
+        for (int s = 0; s < blockSize; s++) {
+            checksum += block[s].data;
+        }
+    }
+    auto rateEnd = std::chrono::high_resolution_clock::now();
+    auto rateDuration = std::chrono::duration_cast<std::chrono::milliseconds>(rateEnd - rateStart).count();
+    printf("\nTime taken | %s: %6i milliseconds | %3i steps", label, static_cast<int>(rateDuration),
+        static_cast<int>(rateGraph.plan.steps.size()));
+    printf("\nresult: %f", checksum);
+}
+
+// 16 channels (UN -> WORK) into 8 buses into one mixer, every channel on every bus with its own gain
+// - weighted: 128 weighted edges, the buses add gain * channel while accumulating
+// - otherwise: a GainNode per channel and bus, 128 more steps
+void benchmarkMixerMatrix(const char* label, bool weighted, int blockSize, int blockCount) {
+    Graph matrixGraph;
+    Graph::ContextScope scope(matrixGraph);
+    SourceNode& source = matrixGraph.emplace<SourceNode>("MM_SN");
+    UpcastNode& upcast = matrixGraph.emplace<UpcastNode>("MM_UN");
+    DecayNode& mixer = matrixGraph.emplace<DecayNode>("MM_MIX");
+    source >> upcast;
+    std::vector<WorkNode*> buses;
+    for (int b = 0; b < 8; b++) {
+        buses.emplace_back(&matrixGraph.emplace<WorkNode>("MM_BUS"));
+        *buses.back() >> mixer;
+    }
+    for (int c = 0; c < 16; c++) {
+        WorkNode& channel = matrixGraph.emplace<WorkNode>("MM_CH");
+        channel.work = 4;
+        upcast >> channel;
+        for (int b = 0; b < 8; b++) {
+            float gain = 1.f / static_cast<float>(1 + (c + b) % 4);
+            if (weighted) {
+                channel * gain >> *buses[b];
+            } else {
+                GainNode& gainNode = matrixGraph.emplace<GainNode>("MM_GAIN");
+                gainNode.gain = gain;
+                channel >> gainNode >> *buses[b];
+            }
+        }
+    }
+    matrixGraph.prepare();
+    matrixGraph.compile();
+    matrixGraph.prepareBlock(blockSize);
+    // prepare() moves the nodes, find the mixer again by name
+    AbstractNode* mixed = nullptr;
+    for (auto node : matrixGraph.nodes) {
+        if (node->name == "MM_MIX") {
+            mixed = node;
+        }
+    }
+
+    auto matrixStart = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < blockCount; i++) {
+        matrixGraph.plan.runBlock(blockSize);
+    }
+    auto matrixEnd = std::chrono::high_resolution_clock::now();
+    auto matrixDuration = std::chrono::duration_cast<std::chrono::milliseconds>(matrixEnd - matrixStart).count();
+    printf("\nTime taken | %s: %6i milliseconds | %3i steps", label, static_cast<int>(matrixDuration),
+        static_cast<int>(matrixGraph.plan.steps.size()));
+    printf("\nresult: %f", static_cast<DecayNode*>(mixed)->viewResult().data);
 }
 
 int main() {
@@ -66,31 +233,6 @@ int main() {
         node->reset();
     }
 
-    // a modified topological sort
-    // - nodes are grouped into "distance from outside edge"
-    // - "outside edge" refers to the farthest upstream node with 0 inputs
-    // NOTE: This sort will be implemented later
-    graph.sortedNodes[0] = {
-        &sourceNode1,
-        &sourceNode2,
-        &sourceNode3,
-        &sourceNode4,
-    };
-
-    graph.sortedNodes[1] = {
-        &upcastNode1,
-        &upcastNode2,
-    };
-
-    graph.sortedNodes[2] = {
-        &floatNode1,
-        &floatNode2,
-    };
-
-    graph.sortedNodes[3] = {
-        &floatNode3,
-    };
-
     for (auto node : graph.nodes) {
         graph.nodeAdjacencyMap[node] = {};
         graph.nodeAdjacencyMap[node].reserve(graph.nodes.size());
@@ -113,6 +255,9 @@ int main() {
     floatNode1 >> floatNode3;
     floatNode2 >> floatNode3;
 
+    graph.prepare();
+    graph.compile();
+
 
     /*
         TYPE MAP
@@ -120,10 +265,9 @@ int main() {
     // TYPE MAP: execute
     auto typeMapStart = std::chrono::high_resolution_clock::now();
     for (int i = 0; i < testIterationCount; i++) {
-        for (auto group : graph.sortedNodes) {
-            for (auto node : group.second) {
-                graph.typeMap[node->getTypeIdInput()](node, graph.nodeAdjacencyMap[node]);
-            }
+        for (int index : graph.schedule.nodeIndices) {
+            AbstractNode* node = graph.nodes[index];
+            graph.typeMap[node->inputFrameTypeId](graph.typeMapPorts[node]);
         }
     }
 
@@ -143,10 +287,8 @@ int main() {
     auto instanceMapStart = std::chrono::high_resolution_clock::now();
 
     for (int i = 0; i < testIterationCount; i++) {
-        for (auto group : graph.sortedNodes) {
-            for (auto node : group.second) {
-                graph.instanceMap[node]();
-            }
+        for (int index : graph.schedule.nodeIndices) {
+            graph.instanceMap[graph.nodes[index]]();
         }
     }
     auto instanceMapEnd = std::chrono::high_resolution_clock::now();
@@ -158,6 +300,516 @@ int main() {
         node->reset();
     }
 
+    /*
+        COMPILED PLAN
+     */
+    // COMPILED PLAN: execute
+    auto compiledPlanStart = std::chrono::high_resolution_clock::now();
+
+    for (int i = 0; i < testIterationCount; i++) {
+        graph.plan.run();
+    }
+    auto compiledPlanEnd = std::chrono::high_resolution_clock::now();
+    auto compiledPlanDuration = std::chrono::duration_cast<std::chrono::milliseconds>(compiledPlanEnd - compiledPlanStart).count();
+    printf("\nTime taken |compiled plan: %6i milliseconds", static_cast<int>(compiledPlanDuration));
+
+    printf("\nresult: %f", dynamic_cast<NodeOutput<FloatFrame>*>(graph.nodes.back())->getResult().data);
+    for (auto node : graph.nodes) {
+        node->reset();
+    }
+
+    /*
+        COMPILED PLAN, BLOCKS
+     */
+    // COMPILED PLAN, BLOCKS: execute, one dispatch per node per block
+    for (int blockSize : { 32, 64, 128, 256, 512 }) {
+        graph.prepareBlock(blockSize);
+        int blockCount = testIterationCount / blockSize;
+
+        auto blockPlanStart = std::chrono::high_resolution_clock::now();
+
+        for (int i = 0; i < blockCount; i++) {
+            graph.plan.runBlock(blockSize);
+        }
+        auto blockPlanEnd = std::chrono::high_resolution_clock::now();
+        auto blockPlanDuration = std::chrono::duration_cast<std::chrono::milliseconds>(blockPlanEnd - blockPlanStart).count();
+        printf("\nTime taken |    block %3i: %6i milliseconds", blockSize, static_cast<int>(blockPlanDuration));
+
+        printf("\nresult: %f", dynamic_cast<NodeOutput<FloatFrame>*>(graph.nodes.back())->getResult().data);
+        for (auto node : graph.nodes) {
+            node->reset();
+        }
+    }
+
+    /*
+        STEREO VIEWS
+     */
+    // STEREO VIEWS: 512 sample stereo frames, one source fanned out to 8 nodes, mixed into one
+    // - instance map copies every provider through getResult(), the compiled plan reads views
+    {
+        Graph stereoGraph;
+        stereoGraph.setContext();
+
+        StereoSourceNode stereoSource("ST_SN");
+        std::vector<std::unique_ptr<StereoDecayNode>> stereoBranches;
+        StereoDecayNode stereoMix("ST_ROOT");
+        stereoGraph.nodes.emplace_back(&stereoSource);
+        for (int i = 0; i < 8; i++) {
+            stereoBranches.emplace_back(std::make_unique<StereoDecayNode>("ST_DN"));
+            stereoGraph.nodes.emplace_back(stereoBranches.back().get());
+        }
+        stereoGraph.nodes.emplace_back(&stereoMix);
+
+        for (auto& branch : stereoBranches) {
+            stereoSource >> *branch;
+            *branch >> stereoMix;
+        }
+        stereoGraph.prepare();
+        stereoGraph.compile();
+
+        int stereoTickCount = testIterationCount / 512;
+
+        auto stereoInstanceStart = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < stereoTickCount; i++) {
+            for (int index : stereoGraph.schedule.nodeIndices) {
+                stereoGraph.instanceMap[stereoGraph.nodes[index]]();
+            }
+        }
+        auto stereoInstanceEnd = std::chrono::high_resolution_clock::now();
+        auto stereoInstanceDuration = std::chrono::duration_cast<std::chrono::microseconds>(stereoInstanceEnd - stereoInstanceStart).count();
+        printf("\nTime taken | stereo clone: %6i microseconds", static_cast<int>(stereoInstanceDuration));
+        printf("\nresult: %f", stereoMix.viewResult().data[0]);
+        for (auto node : stereoGraph.nodes) {
+            node->reset();
+        }
+
+        auto stereoPlanStart = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < stereoTickCount; i++) {
+            stereoGraph.plan.run();
+        }
+        auto stereoPlanEnd = std::chrono::high_resolution_clock::now();
+        auto stereoPlanDuration = std::chrono::duration_cast<std::chrono::microseconds>(stereoPlanEnd - stereoPlanStart).count();
+        printf("\nTime taken |  stereo view: %6i microseconds", static_cast<int>(stereoPlanDuration));
+        printf("\nresult: %f", stereoMix.viewResult().data[0]);
+
+        graph.setContext();
+    }
+
+    /*
+        STATIC GRAPH
+     */
+    // STATIC GRAPH: same 9 node topology as a type
+    // - every UN takes all 4 SN, every FN takes both UN, ROOT takes both FN
+    StaticGraph<
+        Mix<SourceNode, SourceNode, SourceNode, SourceNode>,
+        Mix<UpcastNode, UpcastNode>,
+        Mix<FloatNode, FloatNode>,
+        FloatNode
+    > staticGraph;
+
+    auto staticGraphStart = std::chrono::high_resolution_clock::now();
+
+    FloatFrame staticResult;
+    for (int i = 0; i < testIterationCount; i++) {
+        staticResult = staticGraph.tick(NullFrame());
+    }
+    auto staticGraphEnd = std::chrono::high_resolution_clock::now();
+    auto staticGraphDuration = std::chrono::duration_cast<std::chrono::milliseconds>(staticGraphEnd - staticGraphStart).count();
+    printf("\nTime taken | static graph: %6i milliseconds", static_cast<int>(staticGraphDuration));
+
+    printf("\nresult: %f", staticResult.data);
+    staticGraph.reset();
+
+    /*
+        PARALLEL LEVELS
+     */
+    // PARALLEL LEVELS: execute, blocks of 256 with levels of 2+ nodes spread over the workers
+    int parallelBlockSize = 256;
+    int parallelBlockCount = testIterationCount / parallelBlockSize;
+    int minParallelWidth = 2;
+    // no more workers than cores: extra ones only time-slice and skew the speedups, hardware_concurrency() may be 0
+    int maxWorkerCount = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    graph.prepareBlock(parallelBlockSize);
+
+    benchmarkWorkerCounts(graph, "parallel levels", maxWorkerCount, parallelBlockSize, parallelBlockCount, [&](int workerCount) {
+        return std::make_unique<ParallelLevelExecutor>(graph.plan, workerCount, minParallelWidth);
+    });
+
+    /*
+        DAG SCHEDULER
+     */
+    // DAG SCHEDULER: execute, dependency counters + work stealing, same blocks as PARALLEL LEVELS
+    benchmarkWorkerCounts(graph, "dag scheduler", maxWorkerCount, parallelBlockSize, parallelBlockCount, [&](int workerCount) {
+        return std::make_unique<DagExecutor>(graph.plan, workerCount);
+    });
+
+    /*
+        STATIC PARTITION
+     */
+    // STATIC PARTITION: same blocks, steps assigned to workers once from measured costs, spin flags on cut edges only
+    // - handoffCost is what the partitioner charges per cut edge: a cache line transfer to a spinning worker
+    double handoffCost = 1000.0;
+    std::vector<double> stepCosts = measureStepCosts(graph.plan, parallelBlockSize, 1000);
+    for (auto node : graph.nodes) {
+        node->reset();
+    }
+    benchmarkWorkerCounts(graph, "static partition", maxWorkerCount, parallelBlockSize, parallelBlockCount, [&](int workerCount) {
+        return std::make_unique<StaticExecutor>(graph.plan, partitionPlan(graph.plan, stepCosts, workerCount, handoffCost));
+    });
+
+    StaticSchedule staticSchedule = partitionPlan(graph.plan, stepCosts, 2, handoffCost);
+    staticSchedule.print(graph.plan);
+    {
+        StaticExecutor staticExecutor(graph.plan, staticSchedule);
+        auto staticStart = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < parallelBlockCount; i++) {
+            staticExecutor.runBlock(parallelBlockSize);
+        }
+        auto staticEnd = std::chrono::high_resolution_clock::now();
+        double measuredMakespan = std::chrono::duration<double, std::nano>(staticEnd - staticStart).count() / parallelBlockCount;
+        printf("\nmakespan | predicted %8.0f ns | measured %8.0f ns per block of %i", staticSchedule.makespan, measuredMakespan, parallelBlockSize);
+    }
+    printf("\nresult: %f", floatNode3.getResult().data);
+    for (auto node : graph.nodes) {
+        node->reset();
+    }
+
+    /*
+        FEEDBACK
+     */
+    // FEEDBACK: SN -> UN -> DN, DN >>= DN
+    // - y = 0.5 * (x + y[previous tick/block]), settles at 1
+    Graph feedbackGraph;
+    feedbackGraph.setContext();
+
+    SourceNode feedbackSource("FB_SN");
+    UpcastNode feedbackUpcast("FB_UN");
+    DecayNode feedbackDecay("FB_ROOT");
+    feedbackGraph.nodes = { &feedbackSource, &feedbackUpcast, &feedbackDecay };
+
+    feedbackSource >> feedbackUpcast;
+    feedbackUpcast >> feedbackDecay;
+    feedbackDecay >>= feedbackDecay;
+
+    feedbackGraph.prepare();
+    feedbackGraph.compile();
+    feedbackGraph.prepareBlock(parallelBlockSize);
+
+    auto feedbackStart = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < testIterationCount; i++) {
+        feedbackGraph.plan.run();
+    }
+    auto feedbackEnd = std::chrono::high_resolution_clock::now();
+    auto feedbackDuration = std::chrono::duration_cast<std::chrono::milliseconds>(feedbackEnd - feedbackStart).count();
+    printf("\nTime taken |feedback plan: %6i milliseconds", static_cast<int>(feedbackDuration));
+    printf("\nresult: %f", feedbackDecay.getResult().data);
+    for (auto node : feedbackGraph.nodes) {
+        node->reset();
+    }
+
+    feedbackStart = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < parallelBlockCount; i++) {
+        feedbackGraph.plan.runBlock(parallelBlockSize);
+    }
+    feedbackEnd = std::chrono::high_resolution_clock::now();
+    feedbackDuration = std::chrono::duration_cast<std::chrono::milliseconds>(feedbackEnd - feedbackStart).count();
+    printf("\nTime taken |feedback %3i: %6i milliseconds", parallelBlockSize, static_cast<int>(feedbackDuration));
+    printf("\nresult: %f", feedbackDecay.getResult().data);
+    for (auto node : feedbackGraph.nodes) {
+        node->reset();
+    }
+
+    benchmarkWorkerCounts(feedbackGraph, "dag scheduler, feedback", 2, parallelBlockSize, parallelBlockCount, [&](int workerCount) {
+        return std::make_unique<DagExecutor>(feedbackGraph.plan, workerCount);
+    });
+
+    /*
+        PRUNING
+     */
+    // PRUNING: SN -> UN -> 8 branches of 16 DN, every branch ends in its own sink
+    // - half the sinks muted, compiled plan before / after pruning
+    Graph pruningGraph;
+    pruningGraph.setContext();
+
+    SourceNode pruningSource("PR_SN");
+    UpcastNode pruningUpcast("PR_UN");
+    std::vector<std::unique_ptr<DecayNode>> pruningNodes;
+    std::vector<DecayNode*> pruningSinks;
+    pruningSource >> pruningUpcast;
+    for (int branch = 0; branch < 8; branch++) {
+        Node<FloatFrame, FloatFrame>* previous = nullptr;
+        for (int i = 0; i < 16; i++) {
+            pruningNodes.emplace_back(std::make_unique<DecayNode>("PR_DN"));
+            if (previous == nullptr) {
+                pruningUpcast >> *pruningNodes.back();
+            } else {
+                *previous >> *pruningNodes.back();
+            }
+            previous = pruningNodes.back().get();
+        }
+        pruningSinks.emplace_back(pruningNodes.back().get());
+        pruningGraph.addSink(pruningSinks.back());
+    }
+    pruningGraph.prepare();
+    pruningGraph.prepareBlock(parallelBlockSize);
+
+    for (bool pruned : { false, true }) {
+        if (pruned) {
+            int switched = 0;
+            for (int branch = 0; branch < 4; branch++) {
+                switched += pruningGraph.setSinkActive(pruningSinks[branch], false);
+            }
+            printf("\nmuted 4 of 8 sinks, %i nodes switched off", switched);
+        }
+        pruningGraph.compile();
+
+        auto pruningStart = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < parallelBlockCount; i++) {
+            pruningGraph.plan.runBlock(parallelBlockSize);
+        }
+        auto pruningEnd = std::chrono::high_resolution_clock::now();
+        auto pruningDuration = std::chrono::duration_cast<std::chrono::milliseconds>(pruningEnd - pruningStart).count();
+        printf("\nTime taken | %s: %6i milliseconds | %3i steps",
+            pruned ? "pruned plan " : "full plan   ",
+            static_cast<int>(pruningDuration),
+            static_cast<int>(pruningGraph.plan.steps.size()));
+        printf("\nresult: %f", pruningSinks.back()->getResult().data);
+    }
+
+    /*
+        CONSTANT FOLDING
+     */
+    // CONSTANT FOLDING: SN -> UN -> 8 DN -> FN, only the running sum is stateful
+    // - with foldConstants the SN/UN/DN chain is evaluated once by compile(), FN reads the held output
+    Graph foldingGraph;
+    foldingGraph.setContext();
+
+    SourceNode foldingSource("CF_SN");
+    UpcastNode foldingUpcast("CF_UN");
+    std::vector<std::unique_ptr<DecayNode>> foldingChain;
+    FloatNode foldingRoot("CF_ROOT");
+    foldingSource >> foldingUpcast;
+    Node<IntFrame, FloatFrame>* foldingPrevious = &foldingUpcast;
+    Node<FloatFrame, FloatFrame>* foldingLast = nullptr;
+    for (int i = 0; i < 8; i++) {
+        foldingChain.emplace_back(std::make_unique<DecayNode>("CF_DN"));
+        if (foldingLast == nullptr) {
+            *foldingPrevious >> *foldingChain.back();
+        } else {
+            *foldingLast >> *foldingChain.back();
+        }
+        foldingLast = foldingChain.back().get();
+    }
+    *foldingLast >> foldingRoot;
+    foldingGraph.prepare();
+
+    for (bool fold : { false, true }) {
+        foldingGraph.foldConstants = fold;
+        foldingGraph.compile();
+        foldingGraph.prepareBlock(parallelBlockSize);
+
+        auto foldingStart = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < testIterationCount; i++) {
+            foldingGraph.plan.run();
+        }
+        auto foldingEnd = std::chrono::high_resolution_clock::now();
+        auto foldingDuration = std::chrono::duration_cast<std::chrono::milliseconds>(foldingEnd - foldingStart).count();
+        printf("\nTime taken | %s: %6i milliseconds | %2i steps, %2i folded",
+            fold ? "folded plan " : "plan        ",
+            static_cast<int>(foldingDuration),
+            static_cast<int>(foldingGraph.plan.steps.size()),
+            static_cast<int>(foldingGraph.plan.constantSteps.size()));
+        printf("\nresult: %f", foldingRoot.getResult().data);
+        // reset() marks the folded nodes changed, the next runBlock() refolds them
+        for (auto node : foldingGraph.nodes) {
+            node->reset();
+        }
+
+        foldingStart = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < parallelBlockCount; i++) {
+            foldingGraph.plan.runBlock(parallelBlockSize);
+        }
+        foldingEnd = std::chrono::high_resolution_clock::now();
+        foldingDuration = std::chrono::duration_cast<std::chrono::milliseconds>(foldingEnd - foldingStart).count();
+        printf("\nTime taken | %s: %6i milliseconds", fold ? "folded 256  " : "block 256   ", static_cast<int>(foldingDuration));
+        printf("\nresult: %f", foldingRoot.getResult().data);
+        for (auto node : foldingGraph.nodes) {
+            node->reset();
+        }
+    }
+
+    /*
+        CHAIN FUSION
+     */
+    // CHAIN FUSION: SN -> UN -> 32 DN, every hop single input / single consumer
+    // - with fuseChains the whole chain is one step: one dispatch, no accumulator, no input block copy
+    Graph fusionGraph;
+    fusionGraph.setContext();
+
+    SourceNode fusionSource("CH_SN");
+    UpcastNode fusionUpcast("CH_UN");
+    std::vector<std::unique_ptr<DecayNode>> fusionChain;
+    fusionSource >> fusionUpcast;
+    for (int i = 0; i < 32; i++) {
+        fusionChain.emplace_back(std::make_unique<DecayNode>("CH_DN"));
+        if (i == 0) {
+            fusionUpcast >> *fusionChain.back();
+        } else {
+            *fusionChain[i - 1] >> *fusionChain.back();
+        }
+    }
+    fusionGraph.prepare();
+
+    for (bool fuse : { false, true }) {
+        fusionGraph.fuseChains = fuse;
+        fusionGraph.compile();
+        fusionGraph.prepareBlock(parallelBlockSize);
+        printf("\n%s: %2i steps, %2i dispatches removed per tick/block",
+            fuse ? "fused" : "unfused",
+            static_cast<int>(fusionGraph.plan.steps.size()),
+            static_cast<int>(fusionGraph.plan.chainSteps.size()));
+
+        auto fusionStart = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < testIterationCount; i++) {
+            fusionGraph.plan.run();
+        }
+        auto fusionEnd = std::chrono::high_resolution_clock::now();
+        auto fusionDuration = std::chrono::duration_cast<std::chrono::milliseconds>(fusionEnd - fusionStart).count();
+        printf("\nTime taken | %s: %6i milliseconds", fuse ? "fused plan  " : "plan        ", static_cast<int>(fusionDuration));
+        printf("\nresult: %f", fusionChain.back()->getResult().data * 1e9f);
+        for (auto node : fusionGraph.nodes) {
+            node->reset();
+        }
+
+        fusionStart = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < parallelBlockCount; i++) {
+            fusionGraph.plan.runBlock(parallelBlockSize);
+        }
+        fusionEnd = std::chrono::high_resolution_clock::now();
+        fusionDuration = std::chrono::duration_cast<std::chrono::milliseconds>(fusionEnd - fusionStart).count();
+        printf("\nTime taken | %s: %6i milliseconds", fuse ? "fused 256   " : "block 256   ", static_cast<int>(fusionDuration));
+        printf("\nresult: %f", fusionChain.back()->getResult().data * 1e9f);
+        for (auto node : fusionGraph.nodes) {
+            node->reset();
+        }
+
+        auto fusionExecutor = std::make_unique<DagExecutor>(fusionGraph.plan, 2);
+        fusionStart = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < parallelBlockCount; i++) {
+            fusionExecutor->runBlock(parallelBlockSize);
+        }
+        fusionEnd = std::chrono::high_resolution_clock::now();
+        fusionDuration = std::chrono::duration_cast<std::chrono::milliseconds>(fusionEnd - fusionStart).count();
+        printf("\nTime taken | %s: %6i milliseconds", fuse ? "fused dag 2 " : "dag 2       ", static_cast<int>(fusionDuration));
+        printf("\nresult: %f", fusionChain.back()->getResult().data * 1e9f);
+        for (auto node : fusionGraph.nodes) {
+            node->reset();
+        }
+    }
+
+    /*
+        PIPELINE
+     */
+    // PIPELINE: the unfused chain as 2 / 4 stages of consecutive levels, stage s on block n - s
+    // - one 34 level chain is the worst case for level parallelism, every level is a single step
+    fusionGraph.fuseChains = false;
+    fusionGraph.compile();
+    fusionGraph.prepareBlock(parallelBlockSize);
+    std::vector<double> chainCosts = measureStepCosts(fusionGraph.plan, parallelBlockSize, 100);
+    for (int stageCount : { 2, 4 }) {
+        for (auto node : fusionGraph.nodes) {
+            node->reset();
+        }
+        PipelineExecutor pipeline(fusionGraph, chainCosts, stageCount, parallelBlockSize);
+        auto pipelineStart = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < parallelBlockCount; i++) {
+            pipeline.runBlock(parallelBlockSize);
+        }
+        pipeline.drain();
+        auto pipelineEnd = std::chrono::high_resolution_clock::now();
+        auto pipelineDuration = std::chrono::duration_cast<std::chrono::milliseconds>(pipelineEnd - pipelineStart).count();
+        printf("\nTime taken | pipeline %i  : %6i milliseconds | %i queues | latency %i blocks, %i samples",
+            stageCount, static_cast<int>(pipelineDuration), pipeline.crossStageQueueCount(),
+            pipeline.latencyBlocks(), pipeline.latencyBlocks() * parallelBlockSize);
+        printf("\nresult: %f", fusionChain.back()->getResult().data * 1e9f);
+    }
+    for (auto node : fusionGraph.nodes) {
+        node->reset();
+    }
+
+    /*
+        MIX BUS
+     */
+    // MIX BUS: 2000 inputs into one bus, summed serially in its own step vs through a tree of partial sum steps
+    // - the tree adds in the same order for every worker count, so all its results match bit for bit
+    // - one second of blocks, the bus graph is 2000 times wider than the main graph
+    int busBlockCount = sampleRate / parallelBlockSize;
+    Graph busGraph;
+    SourceNode& busSource = busGraph.emplace<SourceNode>("BUS_SN");
+    UpcastNode& busUpcast = busGraph.emplace<UpcastNode>("BUS_UN");
+    busGraph.connect(busSource, busUpcast);
+    std::vector<WorkNode*> channels;
+    for (int i = 0; i < 2000; i++) {
+        channels.emplace_back(&busGraph.emplace<WorkNode>("BUS_CH"));
+        channels.back()->work = 1;
+        busGraph.connect(busUpcast, *channels.back());
+    }
+    // emplaced last: benchmarkWorkerCounts() reads the last node
+    WorkNode& bus = busGraph.emplace<WorkNode>("BUS");
+    DecayNode& busOutput = busGraph.emplace<DecayNode>("BUS_OUT");
+    for (auto channel : channels) {
+        busGraph.connect(*channel, bus);
+    }
+    busGraph.connect(bus, busOutput);
+    busGraph.prepare();
+    for (int reduceFanIn : { 0, 64 }) {
+        busGraph.reduceFanIn = reduceFanIn;
+        busGraph.compile();
+        busGraph.prepareBlock(parallelBlockSize);
+        printf("\n%i steps, %i levels", static_cast<int>(busGraph.plan.steps.size()),
+            static_cast<int>(busGraph.plan.levelOffsets.size()) - 1);
+        benchmarkWorkerCounts(busGraph, reduceFanIn == 0 ? "bus serial" : "bus tree", maxWorkerCount,
+            parallelBlockSize, busBlockCount, [&](int workerCount) {
+                return std::make_unique<DagExecutor>(busGraph.plan, workerCount);
+            });
+    }
+
+    /*
+        POLYPHONY
+     */
+    // POLYPHONY: 64 voices, cloned as 64 single lane subgraphs vs batched as 8 subgraphs of 8 lanes
+    benchmarkVoices<1, 64>("voices 64x1  ", sampleRate, parallelBlockSize, parallelBlockCount);
+    benchmarkVoices<8, 8>("voices 8x8   ", sampleRate, parallelBlockSize, parallelBlockCount);
+
+    /*
+        MULTI-RATE
+     */
+    // MULTI-RATE: the LFOs at audio rate, every 32 samples held, every 32 / 64 samples ramped
+    benchmarkControlRate("lfo 1       ", 1, false, sampleRate, parallelBlockSize, parallelBlockCount);
+    benchmarkControlRate("lfo 32 hold ", 32, false, sampleRate, parallelBlockSize, parallelBlockCount);
+    benchmarkControlRate("lfo 32 ramp ", 32, true, sampleRate, parallelBlockSize, parallelBlockCount);
+    benchmarkControlRate("lfo 64 ramp ", 64, true, sampleRate, parallelBlockSize, parallelBlockCount);
+
+    /*
+        MIXER MATRIX
+     */
+    // MIXER MATRIX: 16 x 8 channel gains as GainNodes vs as weighted edges
+    benchmarkMixerMatrix("gain nodes  ", false, parallelBlockSize, parallelBlockCount);
+    benchmarkMixerMatrix("weighted    ", true, parallelBlockSize, parallelBlockCount);
+
+    /*
+        PROFILER
+     */
+    // PROFILER: per-node cost of the main graph in blocks of 256, only timed with -DABSTRACT_GRAPH_PROFILE=1
+    graph.setContext();
+    graph.prepareBlock(parallelBlockSize);
+    ProfilingExecutor profiler(graph.plan, sampleRate);
+    for (int i = 0; i < parallelBlockCount; i++) {
+        profiler.runBlock(parallelBlockSize);
+    }
+    profiler.report();
+    printf("\nresult: %f", floatNode3.getResult().data);
+
     printf("\n");
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,78 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+
+#include "FrameBase.h"
+#include "NodeBase.h"
+#include "CustomTypes.h"
+#include "Graph.h"
+#include "GraphGenerator.h"
+#include "GraphFile.h"
+#include "NodeRegistry.h"
+
+// session load time: building a generated graph in C++ vs loading it from a graph file
+// - build: generateDag (Graph::connect wiring, type map, instance lambdas) + prepare + compile
+// - load: mmap the file, create nodes through the registry, restore schedule and edges, compile
+// - both then run the same blocks, the mixer results must match
+double millisecondsSince(std::chrono::high_resolution_clock::time_point start) {
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+float runBlocks(Graph& graph, int mixerIndex, int blockSize, int blockCount) {
+    graph.prepareBlock(blockSize);
+    for (int i = 0; i < blockCount; i++) {
+        graph.plan.runBlock(blockSize);
+    }
+    return static_cast<DecayNode*>(graph.nodes[mixerIndex])->viewResult().data;
+}
+
+int main() {
+    NodeRegistry registry;
+    registry.add<SourceNode>("SourceNode");
+    registry.add<UpcastNode>("UpcastNode");
+    registry.add<DecayNode>("DecayNode");
+    registry.add<FloatNode>("FloatNode");
+    registry.add<WorkNode>("WorkNode", &WorkNode::work);
+
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "abstractGraph.agraph";
+
+    for (int width : { 100, 1000 }) {
+        DagShape shape { "random patch", width, 100, 2, 4, 4, 1 };
+
+        Graph built;
+        auto buildStart = std::chrono::high_resolution_clock::now();
+        GeneratedDag generated = generateDag(built, shape);
+        built.prepare();
+        built.compile();
+        double buildDuration = millisecondsSince(buildStart);
+
+        auto saveStart = std::chrono::high_resolution_clock::now();
+        saveGraph(built, registry, path.c_str());
+        double saveDuration = millisecondsSince(saveStart);
+
+        Graph loaded;
+        auto loadStart = std::chrono::high_resolution_clock::now();
+        loadGraph(loaded, registry, path.c_str());
+        double loadDuration = millisecondsSince(loadStart);
+
+        // saveGraph writes the nodes in schedule order, the mixer's index in the loaded graph is its schedule position
+        auto& schedule = built.schedule.nodeIndices;
+        int loadedMixerIndex = static_cast<int>(std::find(schedule.begin(), schedule.end(), generated.mixerIndex) - schedule.begin());
+
+        float builtResult = runBlocks(built, generated.mixerIndex, 256, 20);
+        float loadedResult = runBlocks(loaded, loadedMixerIndex, 256, 20);
+
+        printf("\n\nnodes: %i, edges: %i, file: %i KB", generated.nodeCount, generated.edgeCount,
+            static_cast<int>(std::filesystem::file_size(path) / 1024));
+        printf("\nTime taken |        build: %8.1f milliseconds", buildDuration);
+        printf("\nTime taken |         save: %8.1f milliseconds", saveDuration);
+        printf("\nTime taken |         load: %8.1f milliseconds", loadDuration);
+        printf("\nresult: %f / %f", builtResult, loadedResult);
+    }
+    std::filesystem::remove(path);
+
+    printf("\n");
+    return 0;
+}
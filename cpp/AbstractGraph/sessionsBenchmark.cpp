@@ -0,0 +1,98 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "FrameBase.h"
+#include "NodeBase.h"
+#include "CustomTypes.h"
+#include "Graph.h"
+#include "GraphGenerator.h"
+
+// independent sessions: every thread builds, compiles and runs its own graph, pinned to its own core
+// - nothing shared between sessions but the frame type ids
+// - throughput is total node ticks over wall time, scaling is against 1 session
+void pinToCore(int core) {
+#ifdef __linux__
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(core, &cpus);
+    pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+#endif
+}
+
+int main() {
+    int blockSize = 256;
+    int blockCount = 2000;
+    int coreCount = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    DagShape shape { "random patch", 16, 16, 2, 4, 4, 16 };
+
+    double singleSessionRate = 0.0;
+    for (int sessionCount : { 1, 2, 4, 8 }) {
+        std::vector<float> results(sessionCount);
+        std::vector<int> nodeCounts(sessionCount);
+        std::atomic<int> ready = 0;
+        std::atomic<bool> go = false;
+
+        auto start = std::chrono::high_resolution_clock::now();
+        std::vector<std::thread> sessions;
+        for (int session = 0; session < sessionCount; session++) {
+            sessions.emplace_back([&, session] {
+                pinToCore(session % coreCount);
+
+                Graph graph;
+                DagShape sessionShape = shape;
+                sessionShape.seed = session + 1;
+                GeneratedDag generated = generateDag(graph, sessionShape);
+                nodeCounts[session] = generated.nodeCount;
+                graph.prepare();
+                graph.compile();
+                graph.prepareBlock(blockSize);
+
+                ready.fetch_add(1);
+                while (!go.load()) {
+                    std::this_thread::yield();
+                }
+                for (int i = 0; i < blockCount; i++) {
+                    graph.plan.runBlock(blockSize);
+                }
+                results[session] = static_cast<DecayNode*>(graph.nodes[generated.mixerIndex])->viewResult().data;
+            });
+        }
+        while (ready.load() != sessionCount) {
+            std::this_thread::yield();
+        }
+        start = std::chrono::high_resolution_clock::now();
+        go = true;
+        for (auto& session : sessions) {
+            session.join();
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+
+        double nodeTicks = 0.0;
+        for (int nodeCount : nodeCounts) {
+            nodeTicks += static_cast<double>(nodeCount) * blockCount * blockSize;
+        }
+        double rate = nodeTicks / (static_cast<double>(duration) / 1e6);
+        if (sessionCount == 1) {
+            singleSessionRate = rate;
+        }
+        printf("\nTime taken |   %2i sessions: %6i milliseconds | %7.1f M nodes/second | scaling %5.2fx | result %f",
+            sessionCount,
+            static_cast<int>(duration / 1000),
+            rate / 1e6,
+            rate / singleSessionRate,
+            results[0]);
+    }
+
+    printf("\n");
+    return 0;
+}
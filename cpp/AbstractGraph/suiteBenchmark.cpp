@@ -0,0 +1,237 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "FrameBase.h"
+#include "NodeBase.h"
+#include "CustomTypes.h"
+#include "Graph.h"
+#include "GraphGenerator.h"
+#include "DagExecutor.h"
+#include "ParallelExecutor.h"
+#include "PipelineExecutor.h"
+#include "StaticExecutor.h"
+#include "StaticPartition.h"
+
+// every executor over the same generated graphs, one row per (shape, executor)
+// - default output is CSV, --json prints a JSON array instead
+// - --shape width depth fanIn fanOut maxSkip work runs one custom shape instead of the presets
+// - nodes/second counts node ticks, budget % is wall time over the audio time processed
+struct SuiteRow {
+    std::string shape;
+    int nodes;
+    int edges;
+    std::string executor;
+    int workers;
+    int samples;
+    double seconds;
+    float result;
+};
+
+struct Suite {
+    int sampleRate = 48000;
+    int blockSize = 256;
+    int64_t nodeTicks = 20'000'000;
+    int workerCount = std::max(2, static_cast<int>(std::thread::hardware_concurrency()));
+    // ns the static partitioner charges per cut edge
+    double handoffCost = 1000.0;
+    std::vector<SuiteRow> rows;
+
+    void runShape(const DagShape& shape) {
+        Graph graph;
+        GeneratedDag generated = generateDag(graph, shape);
+        graph.prepare();
+        graph.compile();
+        graph.prepareBlock(blockSize);
+
+        int blockCount = std::max<int64_t>(1, nodeTicks / generated.nodeCount / blockSize);
+        int samples = blockCount * blockSize;
+        auto sink = static_cast<DecayNode*>(graph.nodes[generated.mixerIndex]);
+
+        auto measure = [&](const char* executor, int workers, auto&& body) {
+            for (auto node : graph.nodes) {
+                node->reset();
+            }
+            auto start = std::chrono::high_resolution_clock::now();
+            body();
+            auto end = std::chrono::high_resolution_clock::now();
+            double seconds = std::chrono::duration<double>(end - start).count();
+            float result = sink->viewResult().data;
+            rows.emplace_back(SuiteRow { shape.name, generated.nodeCount, generated.edgeCount, executor, workers, samples, seconds, result });
+        };
+
+        measure("type map", 1, [&] {
+            for (int i = 0; i < samples; i++) {
+                for (int index : graph.schedule.nodeIndices) {
+                    AbstractNode* node = graph.nodes[index];
+                    graph.typeMap[node->inputFrameTypeId](graph.typeMapPorts[node]);
+                }
+            }
+        });
+        measure("instance map", 1, [&] {
+            for (int i = 0; i < samples; i++) {
+                for (int index : graph.schedule.nodeIndices) {
+                    graph.instanceMap[graph.nodes[index]]();
+                }
+            }
+        });
+        measure("plan", 1, [&] {
+            for (int i = 0; i < samples; i++) {
+                graph.plan.run();
+            }
+        });
+        measure("plan blocks", 1, [&] {
+            for (int i = 0; i < blockCount; i++) {
+                graph.plan.runBlock(blockSize);
+            }
+        });
+        {
+            ParallelLevelExecutor executor(graph.plan, workerCount, 2);
+            measure("parallel levels", workerCount, [&] {
+                for (int i = 0; i < blockCount; i++) {
+                    executor.runBlock(blockSize);
+                }
+            });
+        }
+        {
+            DagExecutor executor(graph.plan, workerCount);
+            measure("dag scheduler", workerCount, [&] {
+                for (int i = 0; i < blockCount; i++) {
+                    executor.runBlock(blockSize);
+                }
+            });
+        }
+        {
+            StaticExecutor executor(graph.plan, partitionPlan(graph.plan, measureStepCosts(graph.plan, blockSize, 20), workerCount, handoffCost));
+            measure("static partition", workerCount, [&] {
+                for (int i = 0; i < blockCount; i++) {
+                    executor.runBlock(blockSize);
+                }
+            });
+        }
+        {
+            // adds latencyBlocks() blocks of latency, drain() is part of the measurement
+            PipelineExecutor executor(graph, measureStepCosts(graph.plan, blockSize, 20), workerCount, blockSize);
+            measure("pipeline", workerCount, [&] {
+                for (int i = 0; i < blockCount; i++) {
+                    executor.runBlock(blockSize);
+                }
+                executor.drain();
+            });
+        }
+
+        graph.fuseChains = true;
+        graph.compile();
+        measure("fused plan blocks", 1, [&] {
+            for (int i = 0; i < blockCount; i++) {
+                graph.plan.runBlock(blockSize);
+            }
+        });
+        {
+            DagExecutor executor(graph.plan, workerCount);
+            measure("fused dag scheduler", workerCount, [&] {
+                for (int i = 0; i < blockCount; i++) {
+                    executor.runBlock(blockSize);
+                }
+            });
+        }
+        {
+            StaticExecutor executor(graph.plan, partitionPlan(graph.plan, measureStepCosts(graph.plan, blockSize, 20), workerCount, handoffCost));
+            measure("fused static partition", workerCount, [&] {
+                for (int i = 0; i < blockCount; i++) {
+                    executor.runBlock(blockSize);
+                }
+            });
+        }
+    }
+
+    void printCsv() const {
+        printf("shape,nodes,edges,executor,workers,samples,seconds,nodes_per_second,ns_per_node_tick,budget_percent,result\n");
+        for (auto& row : rows) {
+            double nodesPerSecond = static_cast<double>(row.nodes) * row.samples / row.seconds;
+            printf("%s,%i,%i,%s,%i,%i,%.6f,%.0f,%.3f,%.3f,%f\n",
+                row.shape.c_str(), row.nodes, row.edges, row.executor.c_str(), row.workers, row.samples,
+                row.seconds, nodesPerSecond, 1e9 / nodesPerSecond, budgetPercent(row), row.result);
+        }
+    }
+
+    void printJson() const {
+        printf("[");
+        for (size_t i = 0; i < rows.size(); i++) {
+            const SuiteRow& row = rows[i];
+            double nodesPerSecond = static_cast<double>(row.nodes) * row.samples / row.seconds;
+            printf("%s\n  {\"shape\": \"%s\", \"nodes\": %i, \"edges\": %i, \"executor\": \"%s\", \"workers\": %i, "
+                "\"samples\": %i, \"seconds\": %.6f, \"nodes_per_second\": %.0f, \"ns_per_node_tick\": %.3f, "
+                "\"budget_percent\": %.3f, \"result\": %f}",
+                i == 0 ? "" : ",",
+                row.shape.c_str(), row.nodes, row.edges, row.executor.c_str(), row.workers, row.samples,
+                row.seconds, nodesPerSecond, 1e9 / nodesPerSecond, budgetPercent(row), row.result);
+        }
+        printf("\n]\n");
+    }
+
+    double budgetPercent(const SuiteRow& row) const {
+        return 100.0 * row.seconds / (static_cast<double>(row.samples) / sampleRate);
+    }
+};
+
+int main(int argc, char** argv) {
+    bool json = false;
+    std::vector<DagShape> shapes = {
+        // name               width depth fanIn fanOut maxSkip work
+        { "effect chain",        1,   48,    1,     1,     1,  16 },
+        { "parallel chains",     8,   16,    1,     1,     1,  16 },
+        { "wide mixer",        128,    2,    8,     8,     1,   8 },
+        { "random patch",       16,   16,    2,     4,     4,  16 },
+        { "dense",              32,    8,    8,     8,     2,   4 },
+    };
+
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--json") == 0) {
+            json = true;
+        } else if (std::strcmp(argv[i], "--shape") == 0) {
+            if (i + 6 >= argc) {
+                fprintf(stderr, "suiteBenchmark: --shape takes width depth fanIn fanOut maxSkip work\n");
+                return 1;
+            }
+            int values[6];
+            for (int v = 0; v < 6; v++) {
+                char* end = nullptr;
+                values[v] = static_cast<int>(std::strtol(argv[i + 1 + v], &end, 10));
+                if (end == argv[i + 1 + v] || *end != '\0') {
+                    fprintf(stderr, "suiteBenchmark: --shape value '%s' is not an integer\n", argv[i + 1 + v]);
+                    return 1;
+                }
+            }
+            shapes = { { "custom", values[0], values[1], values[2], values[3], values[4], values[5] } };
+            i += 6;
+        } else {
+            fprintf(stderr, "suiteBenchmark: unknown argument '%s'\n", argv[i]);
+            return 1;
+        }
+    }
+
+    Suite suite;
+    try {
+        for (auto& shape : shapes) {
+            suite.runShape(shape);
+        }
+    } catch (const std::runtime_error& error) {
+        fprintf(stderr, "suiteBenchmark: %s\n", error.what());
+        return 1;
+    }
+
+    if (json) {
+        suite.printJson();
+    } else {
+        suite.printCsv();
+    }
+    return 0;
+}
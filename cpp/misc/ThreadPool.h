@@ -6,11 +6,12 @@
 #include <memory>
 #include <semaphore>
 
-int effort = 10;
-int task_count = 100;
-int worker_count = 5;
+// inline: the graph executors include this header from several translation units
+inline int effort = 10;
+inline int task_count = 100;
+inline int worker_count = 5;
 
-std::counting_semaphore<> completedWorkSemaphore(0);
+inline std::counting_semaphore<> completedWorkSemaphore(0);
 
 
 class ThreadPool {
@@ -19,14 +20,14 @@ public:
         if (simulateWorkload) {
             for (size_t i = 0; i < numThreads; ++i) {
                 workers.emplace_back([this, i] {
-                    printf("\nstarting: %i", i);
+                    printf("\nstarting: %zu", i);
                     while (true) {
                         newWorkSemaphore.acquire();
                         if (done) {
-                            printf("\ndone: %i", i);
+                            printf("\ndone: %zu", i);
                             break;
                         }
-                        printf("\nworking: %i", i);
+                        printf("\nworking: %zu", i);
                         std::this_thread::sleep_for(std::chrono::milliseconds(effort));
                         completedWorkSemaphore.release();
                     }
@@ -49,7 +50,6 @@ public:
                 worker.join();
             }
         }
-        printf("\n");
     }
 
     void enqueue() {